@@ -0,0 +1,80 @@
+// Copyright (c) 2019 Julian Bernhard
+// 
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#include "benchmark/benchmark.h"
+
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+
+#include "environments/crossing_state.h"
+
+using namespace mcts;
+
+using Domain = int;
+using CrossingMcts = Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+
+namespace {
+
+const unsigned int kMinIterations = 16;
+const unsigned int kReferenceIterations = 2048;
+const unsigned int kNumSeeds = 5;
+
+// Ego decision of a search with a fixed iteration budget, tracker and state are created for each search
+// such that searches with different budgets only differ in their budget
+ActionIdx search_decision(const CrossingStateParameters<Domain>& crossing_state_parameters,
+                          const unsigned int& seed, const unsigned int& num_iterations,
+                          const bool& common_random_numbers) {
+  auto mcts_parameters = mcts_default_parameters();
+  mcts_parameters.RANDOM_SEED = seed;
+  mcts_parameters.MAX_NUMBER_OF_ITERATIONS = num_iterations;
+  mcts_parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  mcts_parameters.random_heuristic.COMMON_RANDOM_NUMBERS = common_random_numbers;
+  mcts_parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING = seed;
+
+  HypothesisBeliefTracker belief_tracker(mcts_parameters);
+  CrossingState<Domain> state(belief_tracker.sample_current_hypothesis(), crossing_state_parameters);
+  state.add_hypothesis(AgentPolicyCrossingState<Domain>({4,5}, crossing_state_parameters));
+  state.add_hypothesis(AgentPolicyCrossingState<Domain>({-2,3}, crossing_state_parameters));
+  state.add_hypothesis(AgentPolicyCrossingState<Domain>({5,6}, crossing_state_parameters));
+  belief_tracker.belief_update(state, state);
+
+  CrossingMcts mcts(mcts_parameters);
+  mcts.search(state, belief_tracker);
+  return mcts.returnBestAction();
+}
+
+} // namespace
+
+// Iterations-to-decision: smallest budget (doubled from kMinIterations) from which on
+// all larger budgets select the decision of the reference budget, averaged over seeds.
+// Arg: 0 = independent rollouts, 1 = common random numbers for sibling rollouts
+static void BM_CrossingStateIterationsToDecision(benchmark::State& state) {
+  const bool common_random_numbers = state.range(0);
+  const auto crossing_state_parameters = default_crossing_state_parameters<Domain>();
+
+  double iterations_to_decision = 0.0;
+  for (auto _ : state) {
+    iterations_to_decision = 0.0;
+    for (unsigned int seed = 1000; seed < 1000 + kNumSeeds; ++seed) {
+      const ActionIdx reference_decision = search_decision(crossing_state_parameters, seed,
+                                                    kReferenceIterations, common_random_numbers);
+      unsigned int stable_from = kReferenceIterations;
+      for (unsigned int num_iterations = kReferenceIterations/2; num_iterations >= kMinIterations; num_iterations /= 2) {
+        if (search_decision(crossing_state_parameters, seed, num_iterations, common_random_numbers) != reference_decision) {
+          break;
+        }
+        stable_from = num_iterations;
+      }
+      iterations_to_decision += static_cast<double>(stable_from) / kNumSeeds;
+    }
+  }
+  state.counters["iterations_to_decision"] = iterations_to_decision;
+}
+BENCHMARK(BM_CrossingStateIterationsToDecision)->Arg(0)->Arg(1)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,131 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+
+#include "environments/crossing_state.h"
+#include "environments/crossing_state_scenario.h"
+
+using namespace mcts;
+
+using Domain = int;
+using CrossingMcts = Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+
+namespace {
+
+const unsigned int kNumIterations = 1000;
+const unsigned int kSeed = 1000;
+
+// Heap usage of the process, each allocation is prefixed by its size
+std::atomic<std::size_t> allocated_bytes(0);
+std::atomic<std::size_t> peak_allocated_bytes(0);
+const std::size_t kAllocationHeader = alignof(std::max_align_t);
+
+void* tracked_allocate(std::size_t size) {
+  void* block = std::malloc(size + kAllocationHeader);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *static_cast<std::size_t*>(block) = size;
+  const std::size_t allocated = allocated_bytes.fetch_add(size) + size;
+  std::size_t peak = peak_allocated_bytes.load();
+  while (allocated > peak && !peak_allocated_bytes.compare_exchange_weak(peak, allocated)) {}
+  return static_cast<char*>(block) + kAllocationHeader;
+}
+
+void tracked_deallocate(void* object) {
+  if (!object) {
+    return;
+  }
+  void* block = static_cast<char*>(object) - kAllocationHeader;
+  allocated_bytes.fetch_sub(*static_cast<std::size_t*>(block));
+  std::free(block);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return tracked_allocate(size); }
+void* operator new[](std::size_t size) { return tracked_allocate(size); }
+void operator delete(void* object) noexcept { tracked_deallocate(object); }
+void operator delete[](void* object) noexcept { tracked_deallocate(object); }
+void operator delete(void* object, std::size_t) noexcept { tracked_deallocate(object); }
+void operator delete[](void* object, std::size_t) noexcept { tracked_deallocate(object); }
+
+// Search with a fixed iteration budget in a generated scenario, the true policies are part of the hypothesis set.
+// Args: number of other agents, chain length, number of hypotheses
+static void BM_CrossingStateScaling(benchmark::State& state) {
+  const unsigned int num_other_agents = state.range(0);
+  const Domain chain_length = state.range(1);
+  const unsigned int num_hypothesis = state.range(2);
+  const auto crossing_state_parameters = crossing_state_scenario_parameters<Domain>(num_other_agents, chain_length, kSeed);
+  const auto hypothesis = crossing_state_scenario_hypothesis(crossing_state_parameters, num_hypothesis, kSeed);
+
+  auto mcts_parameters = mcts_default_parameters();
+  mcts_parameters.RANDOM_SEED = kSeed;
+  mcts_parameters.MAX_NUMBER_OF_ITERATIONS = kNumIterations;
+  mcts_parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  mcts_parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING = kSeed;
+
+  double num_iterations = 0.0;
+  double num_nodes = 0.0;
+  std::size_t peak_search_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    HypothesisBeliefTracker belief_tracker(mcts_parameters);
+    CrossingState<Domain> crossing_state(belief_tracker.sample_current_hypothesis(), crossing_state_parameters);
+    for (const auto& hp : hypothesis) {
+      crossing_state.add_hypothesis(hp);
+    }
+    belief_tracker.belief_update(crossing_state, crossing_state);
+    const std::size_t bytes_before_search = allocated_bytes.load();
+    peak_allocated_bytes.store(bytes_before_search);
+    state.ResumeTiming();
+
+    {
+      CrossingMcts mcts(mcts_parameters);
+      mcts.search(crossing_state, belief_tracker);
+      num_iterations += mcts.numIterations();
+      num_nodes += mcts.numNodes();
+      benchmark::DoNotOptimize(mcts.returnBestAction());
+      state.PauseTiming(); // the tree is released outside of the timing
+    }
+    peak_search_bytes = std::max(peak_search_bytes, peak_allocated_bytes.load() - bytes_before_search);
+    state.ResumeTiming();
+  }
+  state.counters["iterations_per_s"] = benchmark::Counter(num_iterations, benchmark::Counter::kIsRate);
+  state.counters["nodes_per_s"] = benchmark::Counter(num_nodes, benchmark::Counter::kIsRate);
+  state.counters["peak_search_memory_mb"] = static_cast<double>(peak_search_bytes) / (1024.0*1024.0);
+}
+
+// Each dimension is swept separately starting from the default scenario with 2 agents,
+// a chain length of 21 and 3 hypotheses
+static void ScalingArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"agents", "chain_length", "hypotheses"});
+  for (int num_other_agents : {2, 8, 32, 128}) {
+    benchmark->Args({num_other_agents, 21, 3});
+  }
+  for (int chain_length : {41, 81, 161}) {
+    benchmark->Args({2, chain_length, 3});
+  }
+  for (int num_hypothesis : {8, 32, 128}) {
+    benchmark->Args({2, 21, num_hypothesis});
+  }
+}
+BENCHMARK(BM_CrossingStateScaling)->Apply(ScalingArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
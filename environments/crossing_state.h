@@ -8,9 +8,11 @@
 #define CROSSING_STATE_H
 
 #include <iostream>
+#include <memory>
 #include <random>
 #include <unordered_map>
 #include "mcts/hypothesis/hypothesis_state.h"
+#include "mcts/object_pool.h"
 
 #include "environments/viewer.h"
 #include "environments/crossing_state_common.h"
@@ -19,62 +21,129 @@
 
 namespace mcts {
 
-// A simple environment with a 1D state, only if both agents select different actions, they get nearer to the terminal state
-template <typename Domain>
-class CrossingState : public mcts::HypothesisStateInterface<CrossingState<Domain>>
+// A simple environment with a 1D state, only if both agents select different actions, they get nearer to the terminal state.
+// If the number of other agents is given at compile time, agents are stored in fixed size arrays and
+// CrossingStateParameters::NUM_OTHER_AGENTS must match it.
+template <typename Domain, std::size_t NumOtherAgents = DYNAMIC_NUM_AGENTS>
+class CrossingState : public mcts::HypothesisStateInterface<CrossingState<Domain, NumOtherAgents>>,
+                      public mcts::SupportsRandomSeeding,
+                      public mcts::SupportsHashing,
+                      public mcts::SupportsStatePool
 {
 public:
-    CrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+    // Hypotheses are immutable once added, states of a search share them
+    typedef std::vector<AgentPolicyCrossingState<Domain>> HypothesisSet;
+    typedef typename AgentPolicyCrossingState<Domain>::RandomStream RandomStream;
+    typedef typename AgentArray<Domain, NumOtherAgents>::type AgentValues;
+
+    CrossingState(const HypothesisContext& current_agents_hypothesis,
                   const CrossingStateParameters<Domain>& parameters) :
-                            HypothesisStateInterface<CrossingState<Domain>>(current_agents_hypothesis),
-                            hypothesis_(),
-                            other_agent_states_(parameters.NUM_OTHER_AGENTS),
+                            HypothesisStateInterface<CrossingState>(current_agents_hypothesis),
+                            hypothesis_(std::make_shared<const HypothesisSet>()),
+                            state_pool_(),
+                            other_agent_positions_(AgentArray<Domain, NumOtherAgents>::make(parameters.NUM_OTHER_AGENTS,
+                                                                                           AgentState<Domain>().x_pos)),
+                            other_agent_last_actions_(AgentArray<Domain, NumOtherAgents>::make(parameters.NUM_OTHER_AGENTS,
+                                                                                           AgentState<Domain>().last_action)),
                             ego_state_(),
                             terminal_(false),
                             goal_reached_(false),
                             collided_(false),
+                            agent_hash_(0),
                             parameters_(parameters) {
-                                for (auto& state : other_agent_states_) {
-                                    state = AgentState<Domain>();
-                                }
+                                agent_hash_ = calculate_agent_hash(other_agent_positions_, other_agent_last_actions_, ego_state_);
                             }
 
-    CrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+    CrossingState(const HypothesisContext& current_agents_hypothesis,
                   const CrossingStateParameters<Domain>& parameters,
                   const std::vector<AgentState<Domain>>& other_agent_states,
                   const AgentState<Domain>& ego_state,
                   const bool& terminal,
                   const bool& goal_reached,
                   const bool& collided,
-                  const std::vector<AgentPolicyCrossingState<Domain>>& hypothesis
+                  const HypothesisSet& hypothesis
+                  ) : 
+                            CrossingState(current_agents_hypothesis, parameters,
+                                          positions(other_agent_states), last_actions(other_agent_states), ego_state,
+                                          terminal, goal_reached, collided, std::make_shared<const HypothesisSet>(hypothesis),
+                                          std::shared_ptr<BlockPool>(),
+                                          calculate_agent_hash(positions(other_agent_states), last_actions(other_agent_states),
+                                                               ego_state)) {};
+
+    CrossingState(const HypothesisContext& current_agents_hypothesis,
+                  const CrossingStateParameters<Domain>& parameters,
+                  AgentValues other_agent_positions,
+                  AgentValues other_agent_last_actions,
+                  const AgentState<Domain>& ego_state,
+                  const bool& terminal,
+                  const bool& goal_reached,
+                  const bool& collided,
+                  const std::shared_ptr<const HypothesisSet>& hypothesis,
+                  const std::shared_ptr<BlockPool>& state_pool,
+                  const std::size_t& agent_hash
                   ) : 
                             HypothesisStateInterface<CrossingState>(current_agents_hypothesis),
                             hypothesis_(hypothesis),
-                            other_agent_states_(other_agent_states),
+                            state_pool_(state_pool),
+                            other_agent_positions_(std::move(other_agent_positions)),
+                            other_agent_last_actions_(std::move(other_agent_last_actions)),
                             ego_state_(ego_state),
                             terminal_(terminal),
                             goal_reached_(goal_reached),
                             collided_(collided),
+                            agent_hash_(agent_hash),
                             parameters_(parameters) {};
     ~CrossingState() {};
 
+    // Derived states and their per agent buffers are drawn from the pool of this state, constructed states have
+    // no pool and use the heap
     std::shared_ptr<CrossingState> clone() const
     {
-        return std::make_shared<CrossingState>(*this);
+        return std::allocate_shared<CrossingState>(PoolAllocator<CrossingState>(state_pool_), *this);
+    }
+
+    // Copy drawn from the given pool, e.g. the one of a search, which is then passed on to all derived states
+    std::shared_ptr<CrossingState> clone(const std::shared_ptr<BlockPool>& state_pool) const
+    {
+        return std::allocate_shared<CrossingState>(PoolAllocator<CrossingState>(state_pool),
+                                                   this->current_agents_hypothesis_,
+                                                   parameters_,
+                                                   AgentArray<Domain, NumOtherAgents>::copy(other_agent_positions_, state_pool),
+                                                   AgentArray<Domain, NumOtherAgents>::copy(other_agent_last_actions_, state_pool),
+                                                   ego_state_,
+                                                   terminal_,
+                                                   goal_reached_,
+                                                   collided_,
+                                                   hypothesis_,
+                                                   state_pool,
+                                                   agent_hash_);
     }
 
+    // Draws from the random stream active for the calling thread, e.g. the one of the search or of a rollout
     ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const {
-        const HypothesisId agt_hyp_id = this->current_agents_hypothesis_.at(agent_idx);
-        return aconv(hypothesis_.at(agt_hyp_id).act(other_agent_states_[agent_idx-1],
-                                                    ego_state_));
+        const HypothesisId agt_hyp_id = this->get_current_hypothesis(agent_idx);
+        RandomStream* random_stream = RandomStreamScope::active();
+        MCTS_EXPECT_TRUE(random_stream != nullptr, "Planning other agents' actions requires an active random stream");
+        return aconv(hypothesis_->at(agt_hyp_id).act(get_agent_state(agent_idx), ego_state_, *random_stream));
     };
 
     template<typename ActionType = Domain>
     Probability get_probability(const HypothesisId& hypothesis, const AgentIdx& agent_idx, const Domain& action) const { 
         if (agent_idx == this->ego_agent_idx) {
-            return hypothesis_.at(hypothesis).get_probability(ego_state_, ego_state_, action);
+            return hypothesis_->at(hypothesis).get_probability(ego_state_, ego_state_, action);
         } else {
-            return hypothesis_.at(hypothesis).get_probability(other_agent_states_[agent_idx-1], ego_state_, action);
+            return hypothesis_->at(hypothesis).get_probability(get_agent_state(agent_idx), ego_state_, action);
+        }
+    }
+
+    // Evaluates all hypotheses for the same agent and ego state in one pass, used by the belief update
+    template<typename ActionType = Domain>
+    void get_probabilities(const AgentIdx& agent_idx, const Domain& action, std::vector<Probability>& probabilities) const {
+        const auto agent_state = (agent_idx == this->ego_agent_idx) ? ego_state_ : get_agent_state(agent_idx);
+        const auto& hypothesis_set = *hypothesis_;
+        probabilities.resize(hypothesis_set.size());
+        for (HypothesisId hypothesis = 0; hypothesis < hypothesis_set.size(); ++hypothesis) {
+            probabilities[hypothesis] = hypothesis_set[hypothesis].get_probability(agent_state, ego_state_, action);
         }
     }
 
@@ -83,15 +152,15 @@ public:
         if (agent_idx == this->ego_agent_idx) {
             return ego_state_.last_action;
         } else {
-            return other_agent_states_[agent_idx-1].last_action;
+            return other_agent_last_actions_[agent_idx-1];
         }
     }
 
     Probability get_prior(const HypothesisId& hypothesis, const AgentIdx& agent_idx) const { return 0.5f;}
 
-    HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return hypothesis_.size();}
+    HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return hypothesis_->size();}
 
-    std::shared_ptr<CrossingState<Domain>> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
+    std::shared_ptr<CrossingState> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
         // normally we map each single action value in joint action with a map to the floating point action. Here, not required
         
         const auto old_x_ego = ego_state_.x_pos;
@@ -102,26 +171,40 @@ public:
         }
         const AgentState<Domain> next_ego_state(new_x_ego, idx_to_ego_crossing_action(joint_action[this->ego_agent_idx]));
 
-        std::vector<AgentState<Domain>> next_other_agent_states(other_agent_states_.size());
-        bool collision = false;
-        for(size_t i = 0; i < other_agent_states_.size(); ++i) {
-            const auto& old_state = other_agent_states_[i];
-            auto new_x = old_state.x_pos + static_cast<Domain>(aconv<Domain>(joint_action[i+1]));
-            next_other_agent_states[i] = AgentState<Domain>( (new_x>= 0) ? new_x : 0, aconv<Domain>(joint_action[i+1]));
-
-            // if ego state history encloses crossing point and other state history encloses crossing point
-            // a collision occurs
-            if(next_ego_state.x_pos >= parameters_.CROSSING_POINT() &&  old_x_ego<= parameters_.CROSSING_POINT() &&
-              next_other_agent_states[i].x_pos >= parameters_.CROSSING_POINT() && 
-              other_agent_states_[i].x_pos <= parameters_.CROSSING_POINT() ) {
-                collision = true;
+        // Agents are updated on contiguous arrays, the loops are free of branches to allow vectorization
+        const std::size_t num_other_agents = other_agent_positions_.size();
+        const Domain crossing_point = parameters_.CROSSING_POINT();
+        // Trip counts of the loops are constant for a fixed number of agents
+        auto next_other_agent_positions = AgentArray<Domain, NumOtherAgents>::make(num_other_agents, Domain(), state_pool_);
+        auto next_other_agent_last_actions = AgentArray<Domain, NumOtherAgents>::make(num_other_agents, Domain(), state_pool_);
+        for(std::size_t i = 0; i < num_other_agents; ++i) {
+            next_other_agent_last_actions[i] = aconv<Domain>(joint_action[i+1]);
+        }
+        bool other_agent_crossed = false;
+        for(std::size_t i = 0; i < num_other_agents; ++i) {
+            const Domain new_x = other_agent_positions_[i] + next_other_agent_last_actions[i];
+            next_other_agent_positions[i] = (new_x >= 0) ? new_x : 0;
+            other_agent_crossed |= (next_other_agent_positions[i] >= crossing_point) & (other_agent_positions_[i] <= crossing_point);
+        }
+        // if ego state history encloses crossing point and other state history encloses crossing point
+        // a collision occurs
+        const bool collision = other_agent_crossed && next_ego_state.x_pos >= crossing_point && old_x_ego <= crossing_point;
+
+        // Zobrist hash of the successor, only the keys of changed agents are exchanged
+        std::size_t agent_hash = agent_hash_ ^ agent_key(this->ego_agent_idx, ego_state_.x_pos, ego_state_.last_action)
+                                             ^ agent_key(this->ego_agent_idx, next_ego_state.x_pos, next_ego_state.last_action);
+        for(std::size_t i = 0; i < num_other_agents; ++i) {
+            if(next_other_agent_positions[i] != other_agent_positions_[i] ||
+               next_other_agent_last_actions[i] != other_agent_last_actions_[i]) {
+                agent_hash ^= agent_key(i+1, other_agent_positions_[i], other_agent_last_actions_[i])
+                            ^ agent_key(i+1, next_other_agent_positions[i], next_other_agent_last_actions[i]);
             }
         }
 
         const bool goal_reached = (next_ego_state.x_pos >= parameters_.EGO_GOAL_POS) && !collision;
 
         const bool terminal = goal_reached || collision || ego_out_of_map;
-        rewards.resize(other_agent_states_.size()+1);
+        rewards.resize(num_other_agents+1);
         rewards[0] = goal_reached * parameters_.REWARD_GOAL_REACHED
                    + collision * parameters_.REWARD_COLLISION + parameters_.REWARD_COLLISION * ego_out_of_map
                    + parameters_.REWARD_STEP;
@@ -131,14 +214,30 @@ public:
           ego_cost = -1.0f*rewards[0];
         }
 
-        return std::make_shared<CrossingState<Domain>>(this->current_agents_hypothesis_,
+        return std::allocate_shared<CrossingState>(PoolAllocator<CrossingState>(state_pool_),
+                                                       this->current_agents_hypothesis_,
                                                        parameters_,
-                                                       next_other_agent_states,
+                                                       std::move(next_other_agent_positions),
+                                                       std::move(next_other_agent_last_actions),
                                                        next_ego_state,
                                                        terminal,
                                                        goal_reached,
                                                        collision,
-                                                       hypothesis_);
+                                                       hypothesis_,
+                                                       state_pool_,
+                                                       agent_hash);
+    }
+
+    std::size_t hash() const {
+        return agent_hash_ ^ (terminal_ | goal_reached_ << 1 | collided_ << 2);
+    }
+
+    bool equals(const CrossingState& other) const {
+        return agent_hash_ == other.agent_hash_ &&
+               ego_state_.x_pos == other.ego_state_.x_pos && ego_state_.last_action == other.ego_state_.last_action &&
+               other_agent_positions_ == other.other_agent_positions_ &&
+               other_agent_last_actions_ == other.other_agent_last_actions_ &&
+               terminal_ == other.terminal_ && goal_reached_ == other.goal_reached_ && collided_ == other.collided_;
     }
 
     ActionIdx get_num_actions(AgentIdx agent_idx) const {
@@ -153,10 +252,8 @@ public:
         return terminal_;
     }
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        std::vector<AgentIdx> agent_idx(other_agent_states_.size());
-        std::iota(agent_idx.begin(), agent_idx.end(), 1); // start from 1 since 0 is ego agent
-        return agent_idx; // adapt to number of agents
+    AgentIdxRange get_other_agent_idx_range() const {
+        return AgentIdxRange(1, other_agent_positions_.size() + 1); // start from 1 since 0 is ego agent
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -168,20 +265,31 @@ public:
         std::stringstream ss;
         ss << "Ego: x=" << ego_state_.x_pos;
         int i = 0;
-        for (const auto& st : other_agent_states_) {
-            ss << ", Ag" << i << ": x=" << st.x_pos;
+        for (const auto& x_pos : other_agent_positions_) {
+            ss << ", Ag" << i << ": x=" << x_pos;
             i++;
         } 
         ss << std::endl;
         return ss.str();
     }
 
+    // States created before keep the former hypothesis set
     void add_hypothesis(const AgentPolicyCrossingState<Domain>& hypothesis) {
-        hypothesis_.push_back(hypothesis);
+        auto hypothesis_set = std::make_shared<HypothesisSet>(*hypothesis_);
+        hypothesis_set->push_back(hypothesis);
+        hypothesis_ = hypothesis_set;
     }
 
     void clear_hypothesis() {
-        hypothesis_.clear();
+        hypothesis_ = std::make_shared<const HypothesisSet>();
+    }
+
+    const std::shared_ptr<const HypothesisSet>& get_hypothesis_set() const {
+        return hypothesis_;
+    }
+
+    const std::shared_ptr<BlockPool>& get_state_pool() const {
+        return state_pool_;
     }
 
     bool ego_goal_reached() const {
@@ -194,7 +302,7 @@ public:
 
     int min_distance_to_ego() const {
         int min_dist = std::numeric_limits<int>::max();
-        for (int i = 0; i < other_agent_states_.size(); ++i) {
+        for (AgentIdx i = 0; i < other_agent_positions_.size(); ++i) {
             const auto dist = distance_to_ego(i);
             if (min_dist > dist) {
                 min_dist = dist;
@@ -204,19 +312,33 @@ public:
     }
 
     inline AgentState<Domain> get_agent_state(const AgentIdx& agent_idx) const {
-        return other_agent_states_[agent_idx-1];
+        return AgentState<Domain>(other_agent_positions_[agent_idx-1], other_agent_last_actions_[agent_idx-1]);
     }
 
     inline AgentState<Domain> get_ego_state() const {
         return ego_state_;
     }
 
-    inline const std::vector<AgentState<Domain>>& get_agent_states() const {
-        return other_agent_states_;
+    // Builds the agent states from the position and last action arrays
+    inline std::vector<AgentState<Domain>> get_agent_states() const {
+        std::vector<AgentState<Domain>> agent_states;
+        agent_states.reserve(other_agent_positions_.size());
+        for (std::size_t i = 0; i < other_agent_positions_.size(); ++i) {
+            agent_states.emplace_back(other_agent_positions_[i], other_agent_last_actions_[i]);
+        }
+        return agent_states;
+    }
+
+    inline const AgentValues& get_agent_positions() const {
+        return other_agent_positions_;
+    }
+
+    inline const AgentValues& get_agent_last_actions() const {
+        return other_agent_last_actions_;
     }
 
     inline int distance_to_ego(const AgentIdx& other_agent_idx) const {
-        return ego_state_.x_pos - other_agent_states_[other_agent_idx].x_pos;
+        return ego_state_.x_pos - other_agent_positions_[other_agent_idx];
     }
 
     
@@ -229,9 +351,10 @@ public:
 
         // draw lines equally spaced angles with small points
         // indicating states and larger points indicating the current state
-        const float angle_delta = M_PI/(other_agent_states_.size()+2); // one for ego 
+        const std::size_t num_other_agents = other_agent_positions_.size();
+        const float angle_delta = M_PI/(num_other_agents+2); // one for ego 
         const float line_radius = state_draw_dst*(parameters_.CHAIN_LENGTH-1)/2.0f;
-        for(int i = 0; i < other_agent_states_.size()+1; ++i) {
+        for(std::size_t i = 0; i < num_other_agents+1; ++i) {
             float start_angle = 1.5*M_PI - (i+1)*angle_delta;
             float end_angle = start_angle + M_PI;
             std::pair<float, float> line_x{cos(start_angle)*line_radius, cos(end_angle)*line_radius };
@@ -240,15 +363,15 @@ public:
 
             // Differentiate between ego and other agents
             AgentState<Domain> state;
-            if(i == std::floor(other_agent_states_.size()/2)) {
+            if(i == std::floor(num_other_agents/2)) {
                 state = ego_state_;
                 color = {0.8,0,0,0}; 
             } else {
                 AgentIdx agt_idx = i;
-                if (i > std::floor(other_agent_states_.size()/2)) {
+                if (i > std::floor(num_other_agents/2)) {
                     agt_idx  = i-1;
                 }
-                state = other_agent_states_[agt_idx];
+                state = AgentState<Domain>(other_agent_positions_[agt_idx], other_agent_last_actions_[agt_idx]);
             }
             viewer->drawLine(line_x, line_y,
                 linewidth, color);
@@ -289,13 +412,47 @@ public:
 
     typedef Domain ActionType;
 private:
-    std::vector<AgentPolicyCrossingState<Domain>> hypothesis_;
+    static AgentValues positions(const std::vector<AgentState<Domain>>& agent_states) {
+        auto x_pos = AgentArray<Domain, NumOtherAgents>::make(agent_states.size());
+        for (std::size_t i = 0; i < agent_states.size(); ++i) {
+            x_pos[i] = agent_states[i].x_pos;
+        }
+        return x_pos;
+    }
+
+    static AgentValues last_actions(const std::vector<AgentState<Domain>>& agent_states) {
+        auto last_action = AgentArray<Domain, NumOtherAgents>::make(agent_states.size());
+        for (std::size_t i = 0; i < agent_states.size(); ++i) {
+            last_action[i] = agent_states[i].last_action;
+        }
+        return last_action;
+    }
+
+    static std::size_t agent_key(const AgentIdx& agent_idx, const Domain& x_pos, const Domain& last_action) {
+        return zobrist_key(2*agent_idx, x_pos) ^ zobrist_key(2*agent_idx + 1, last_action);
+    }
+
+    static std::size_t calculate_agent_hash(const AgentValues& other_agent_positions,
+                                            const AgentValues& other_agent_last_actions,
+                                            const AgentState<Domain>& ego_state) {
+        std::size_t agent_hash = agent_key(0, ego_state.x_pos, ego_state.last_action); // ego agent has index 0
+        for (std::size_t i = 0; i < other_agent_positions.size(); ++i) {
+            agent_hash ^= agent_key(i+1, other_agent_positions[i], other_agent_last_actions[i]);
+        }
+        return agent_hash;
+    }
+
+    std::shared_ptr<const HypothesisSet> hypothesis_;
+    std::shared_ptr<BlockPool> state_pool_; // shared by all states derived from a pooled copy, nullptr if not pooled
 
-    std::vector<AgentState<Domain>> other_agent_states_;
+    // Struct of arrays, indexed by agent index - 1
+    AgentValues other_agent_positions_;
+    AgentValues other_agent_last_actions_;
     AgentState<Domain> ego_state_;
     const bool terminal_;
     const bool goal_reached_;
     const bool collided_;
+    std::size_t agent_hash_; // Zobrist hash of positions and last actions, updated incrementally by execute
 
     const CrossingStateParameters<Domain>& parameters_;
 };
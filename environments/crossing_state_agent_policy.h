@@ -9,7 +9,10 @@
 #define MCTS_CROSSING_STATE_AGENT_POLICY_H_
 
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <random>
+#include <type_traits>
 #include <unordered_map>
 #include "mcts/random_generator.h"
 #include "environments/crossing_state_common.h"
@@ -17,18 +20,34 @@
 
 namespace mcts {
 
+// Policies are immutable after construction, random numbers are drawn from the stream passed by the caller.
+// A policy can thus be shared by states, searches and threads, each owning its stream.
 template <typename Domain>
-class AgentPolicyCrossingState : public RandomGenerator {
+class AgentPolicyCrossingState {
   public:
     AgentPolicyCrossingState(const std::pair<Domain, Domain>& desired_gap_range,
                             const CrossingStateParameters<Domain>& parameters) : 
-                            RandomGenerator(parameters.OTHER_AGENTS_POLICY_RANDOM_SEED),
                             desired_gap_range_(desired_gap_range),
-                            parameters_(parameters) {
+                            parameters_(parameters),
+                            probability_table_(),
+                            table_min_gap_error_(0),
+                            table_max_gap_error_(0),
+                            gap_range_type_(INVALID_GAP_RANGE),
+                            gap_range_constants_() {
                                 MCTS_EXPECT_TRUE(desired_gap_range.first <= desired_gap_range.second);
+                                init_probability_tables();
                             }
 
-    Domain act(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state) const;
+    // Streams are owned by the callers, the policies of a hypothesis set are shared by all states
+    typedef mcts::RandomStream RandomStream;
+
+    template<typename Generator>
+    Domain act(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state, Generator& random_generator) const {
+        // sample desired gap parameter
+        DesiredGapDistribution dis(desired_gap_range_.first, desired_gap_range_.second);
+        const Domain desired_gap_dst = dis(random_generator);
+        return calculate_action(agent_state, ego_state, desired_gap_dst);
+    }
 
     Probability get_probability(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state, const Domain& action) const;
 
@@ -37,6 +56,44 @@ class AgentPolicyCrossingState : public RandomGenerator {
         if(agent_state.x_pos < parameters_.CROSSING_POINT() ) {
             // use a forward predicted ego state based on the last action
             const auto gap_error = ego_state.x_pos + ego_state.last_action - agent_state.x_pos - desired_gap_dst;
+            return action_for_gap_error(gap_error, desired_gap_dst, agent_state.last_action);
+        } else {
+            return agent_state.last_action;
+        }
+
+    }
+
+    std::string info() const {
+      std::stringstream ss;
+      ss << "[" << desired_gap_range_.first << ", " << desired_gap_range_.second << "]";
+      return ss.str();
+    }
+
+  private: 
+        typedef typename std::conditional<std::is_integral<Domain>::value, std::uniform_int_distribution<Domain>,
+                                          std::uniform_real_distribution<Domain>>::type DesiredGapDistribution;
+
+        typedef enum GapRangeType {
+            POSITIVE_GAP_RANGE,
+            NEGATIVE_GAP_RANGE,
+            MIXED_GAP_RANGE,
+            INVALID_GAP_RANGE
+        } GapRangeType;
+
+        // Factors of the piecewise probabilities of the float domain, they only depend on the desired gap range
+        struct GapRangeConstants {
+            GapRangeConstants() : uniform_prob_pos_range(0.0f), single_sample_prob_pos_range(0.0f),
+                                  uniform_prob_neg_range(0.0f), single_sample_prob_neg_range(0.0f),
+                                  positive_range_prob(0.0), negative_range_prob(0.0) {}
+            float uniform_prob_pos_range;
+            float single_sample_prob_pos_range;
+            float uniform_prob_neg_range;
+            float single_sample_prob_neg_range;
+            Probability positive_range_prob; // share of the desired gap range above zero
+            Probability negative_range_prob;
+        };
+
+        Domain action_for_gap_error(const Domain& gap_error, const Domain& desired_gap_dst, const Domain& last_action) const {
             // gap_error < 0 -> brake to increase distance
             if (desired_gap_dst > 0) {
                 if(gap_error < 0) {
@@ -46,46 +103,101 @@ class AgentPolicyCrossingState : public RandomGenerator {
                 }
             } else {
                 // Dont brake again if agents is already ahead of ego agent, but continue with same velocity
-                return std::max(std::min(gap_error, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action);
+                return std::max(std::min(gap_error, parameters_.MAX_VELOCITY_OTHER), last_action);
             }
-        } else {
-            return agent_state.last_action;
         }
 
-    }
+        // Called once per policy, the belief tracker queries the probabilities of all hypotheses in each step
+        void init_probability_tables();
 
-    std::string info() const {
-      std::stringstream ss;
-      ss << "[" << desired_gap_range_.first << ", " << desired_gap_range_.second << "]";
-      return ss.str();
-    }
+        Probability get_probability_enumerated(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state,
+                                               const Domain& action) const;
+
+        static float gap_discretization() { return 0.001f; }
+
+        Probability probability_positive_gap_error(const Domain& action, const float gap_error_min, const float gap_error_max,
+                                                   const float uniform_prob, const float single_sample_prob) const;
+
+        Probability probability_negative_gap_error(const AgentState<Domain>& agent_state, const Domain& action,
+                                                   const float gap_error_min, const float gap_error_max,
+                                                   const float uniform_prob, const float single_sample_prob) const;
 
-  private: 
         const std::pair<Domain, Domain> desired_gap_range_;
         const CrossingStateParameters<Domain>& parameters_;
+
+        // Int domain: probabilities indexed by (gap error at zero desired gap, last action, action), shared by copies
+        std::shared_ptr<const std::vector<Probability>> probability_table_;
+        Domain table_min_gap_error_; // gap errors outside of the table yield the same actions as its boundaries
+        Domain table_max_gap_error_;
+
+        // Float domain
+        GapRangeType gap_range_type_;
+        GapRangeConstants gap_range_constants_;
 };
 
 template <>
-inline int AgentPolicyCrossingState<int>::act(const AgentState<int>& agent_state, const AgentState<int>& ego_state) const {
-    // sample desired gap parameter
-    std::uniform_int_distribution<int> dis(desired_gap_range_.first, desired_gap_range_.second);
-    int desired_gap_dst = dis(this->random_generator_);
-
-    return calculate_action(agent_state, ego_state, desired_gap_dst);
+inline void AgentPolicyCrossingState<int>::init_probability_tables() {
+    // Beyond these gap errors each desired gap yields the minimum or maximum velocity
+    table_min_gap_error_ = desired_gap_range_.first + parameters_.MIN_VELOCITY_OTHER - 1;
+    table_max_gap_error_ = desired_gap_range_.second + parameters_.MAX_VELOCITY_OTHER + 1;
+    const int num_velocities = parameters_.MAX_VELOCITY_OTHER - parameters_.MIN_VELOCITY_OTHER + 1;
+    const int num_gaps = desired_gap_range_.second - desired_gap_range_.first + 1;
+    // Only if zero is a valid velocity all calculated actions lie within the velocity limits,
+    // otherwise probabilities are enumerated
+    if (num_velocities <= 0 || num_gaps <= 0 ||
+            parameters_.MIN_VELOCITY_OTHER > 0 || parameters_.MAX_VELOCITY_OTHER < 0) {
+        return;
+    }
+    auto probability_table = std::make_shared<std::vector<Probability>>(
+                (table_max_gap_error_ - table_min_gap_error_ + 1)*num_velocities*num_velocities, 0.0);
+    std::vector<unsigned int> action_counts(num_velocities);
+    for (int gap_error = table_min_gap_error_; gap_error <= table_max_gap_error_; ++gap_error) {
+        for (int last_action = parameters_.MIN_VELOCITY_OTHER; last_action <= parameters_.MAX_VELOCITY_OTHER; ++last_action) {
+            std::fill(action_counts.begin(), action_counts.end(), 0);
+            for (int desired_gap_dst = desired_gap_range_.first; desired_gap_dst <= desired_gap_range_.second; ++desired_gap_dst) {
+                const int action = action_for_gap_error(gap_error - desired_gap_dst, desired_gap_dst, last_action);
+                MCTS_EXPECT_TRUE(action >= parameters_.MIN_VELOCITY_OTHER && action <= parameters_.MAX_VELOCITY_OTHER);
+                action_counts[action - parameters_.MIN_VELOCITY_OTHER]++;
+            }
+            const std::size_t offset = ((gap_error - table_min_gap_error_)*num_velocities +
+                                        last_action - parameters_.MIN_VELOCITY_OTHER)*num_velocities;
+            for (int action_idx = 0; action_idx < num_velocities; ++action_idx) {
+                (*probability_table)[offset + action_idx] = static_cast<float>(action_counts[action_idx])/static_cast<float>(num_gaps);
+            }
+        }
+    }
+    probability_table_ = probability_table;
 }
 
 template <>
-inline float AgentPolicyCrossingState<float>::act(const AgentState<float>& agent_state, const AgentState<float>& ego_state) const {
-    // sample desired gap parameter
-    std::uniform_real_distribution<float> dis(desired_gap_range_.first, desired_gap_range_.second);
-    float desired_gap_dst = dis(this->random_generator_);
-
-    return calculate_action(agent_state, ego_state, desired_gap_dst);
+inline void AgentPolicyCrossingState<float>::init_probability_tables() {
+    if ( desired_gap_range_.first >= 0 && desired_gap_range_.second > 0) {
+        gap_range_type_ = POSITIVE_GAP_RANGE;
+        const Probability uniform_prob = 1/std::abs(desired_gap_range_.second-desired_gap_range_.first);
+        gap_range_constants_.uniform_prob_pos_range = uniform_prob;
+        gap_range_constants_.single_sample_prob_pos_range = uniform_prob * gap_discretization();
+    } else if(desired_gap_range_.first < 0 && desired_gap_range_.second <= 0) {
+        gap_range_type_ = NEGATIVE_GAP_RANGE;
+        const Probability uniform_prob = 1/std::abs(desired_gap_range_.second-desired_gap_range_.first);
+        gap_range_constants_.uniform_prob_neg_range = uniform_prob;
+        gap_range_constants_.single_sample_prob_neg_range = uniform_prob * gap_discretization();
+    } else if(desired_gap_range_.first < 0 && desired_gap_range_.second > 0) {
+        // Split up gap range into negative and positive part and combine with probability OR
+        gap_range_type_ = MIXED_GAP_RANGE;
+        const Probability uniform_prob_pos_range = 1/desired_gap_range_.second;
+        const Probability uniform_prob_neg_range = 1/-desired_gap_range_.first;
+        gap_range_constants_.uniform_prob_pos_range = uniform_prob_pos_range;
+        gap_range_constants_.uniform_prob_neg_range = uniform_prob_neg_range;
+        gap_range_constants_.single_sample_prob_pos_range = uniform_prob_pos_range * gap_discretization();
+        gap_range_constants_.single_sample_prob_neg_range = uniform_prob_neg_range * gap_discretization();
+        gap_range_constants_.negative_range_prob = (-desired_gap_range_.first)/std::abs(desired_gap_range_.second-desired_gap_range_.first);
+        gap_range_constants_.positive_range_prob = (desired_gap_range_.second)/std::abs(desired_gap_range_.second-desired_gap_range_.first);
+    }
 }
 
-
 template <>
-inline Probability AgentPolicyCrossingState<int>::get_probability(const AgentState<int>& agent_state, const AgentState<int>& ego_state, const int& action) const {
+inline Probability AgentPolicyCrossingState<int>::get_probability_enumerated(const AgentState<int>& agent_state,
+                                                        const AgentState<int>& ego_state, const int& action) const {
     std::vector<int> gap_distances(desired_gap_range_.second - desired_gap_range_.first+1);
     std::iota(gap_distances.begin(), gap_distances.end(),desired_gap_range_.first);
     unsigned int action_selected = 0;
@@ -100,146 +212,163 @@ inline Probability AgentPolicyCrossingState<int>::get_probability(const AgentSta
 }
 
 template <>
-inline Probability AgentPolicyCrossingState<float>::get_probability(const AgentState<float>& agent_state, const AgentState<float>& ego_state, const float& action) const {
-    const float gap_discretization = 0.001f;
-    MCTS_EXPECT_TRUE((desired_gap_range_.second-desired_gap_range_.first) > gap_discretization);
+inline Probability AgentPolicyCrossingState<int>::get_probability(const AgentState<int>& agent_state, const AgentState<int>& ego_state, const int& action) const {
+    if(agent_state.x_pos >= parameters_.CROSSING_POINT()) {
+        return action == agent_state.last_action ? 1.0f : 0.0f;
+    }
+    // The table covers last actions within the velocity limits, others are enumerated as before
+    if(!probability_table_ || agent_state.last_action < parameters_.MIN_VELOCITY_OTHER ||
+            agent_state.last_action > parameters_.MAX_VELOCITY_OTHER) {
+        return get_probability_enumerated(agent_state, ego_state, action);
+    }
+    if(action < parameters_.MIN_VELOCITY_OTHER || action > parameters_.MAX_VELOCITY_OTHER) {
+        return 0.0f;
+    }
+    const int num_velocities = parameters_.MAX_VELOCITY_OTHER - parameters_.MIN_VELOCITY_OTHER + 1;
+    const int gap_error = std::min(std::max(ego_state.x_pos + ego_state.last_action - agent_state.x_pos, table_min_gap_error_),
+                                   table_max_gap_error_);
+    return (*probability_table_)[((gap_error - table_min_gap_error_)*num_velocities +
+                                  agent_state.last_action - parameters_.MIN_VELOCITY_OTHER)*num_velocities +
+                                  action - parameters_.MIN_VELOCITY_OTHER];
+}
+
+template <>
+inline Probability AgentPolicyCrossingState<float>::probability_positive_gap_error(const float& action,
+                                                    const float gap_error_min, const float gap_error_max,
+                                                    const float uniform_prob, const float single_sample_prob) const {
     auto prob_between = [&](float left, float right, float uniform_prob) -> Probability {
-        return std::max(right - left, gap_discretization) * uniform_prob;
+        return std::max(right - left, gap_discretization()) * uniform_prob;
     };
     const Probability zero_prob = 0.0f;
     const Probability one_prob = 1.0f;
-   
-    // Lambda function to calculate probability for positive gap errors    
-    auto probability_positive_gap_error = [&](const float gap_error_min, const float gap_error_max,
-                                              const float uniform_prob, const float single_sample_prob)
-                                              -> Probability {
-        // For both boundaries of gap range gap error is negative 
-        if(gap_error_min < 0 && gap_error_max <= 0 &&
-            action <= std::max(gap_error_min, parameters_.MIN_VELOCITY_OTHER) &&
-                action >= std::max(gap_error_max, parameters_.MIN_VELOCITY_OTHER) ) {
-                    // Consider boundaries due to maximum and minimum operations
-                if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
-                gap_error_min < parameters_.MIN_VELOCITY_OTHER &&
-                    action == parameters_.MIN_VELOCITY_OTHER) {
-                    return one_prob;
-                } else if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
-                    action == parameters_.MIN_VELOCITY_OTHER) {
-                        return prob_between(gap_error_max, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
-                    } else if(gap_error_min < parameters_.MIN_VELOCITY_OTHER &&
-                    action == parameters_.MIN_VELOCITY_OTHER) {
-                        return prob_between(gap_error_min, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
-                } else {
-                        return single_sample_prob;
-                }
-        // For only the higher desired gap the gap error is negative -> 
-        } else if(gap_error_min >= 0 && gap_error_max <= 0 &&
-            action <= std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) &&
-            action >= std::max(gap_error_max, parameters_.MIN_VELOCITY_OTHER) ) 
-        {
-            // Consider boundaries due to maximum and minimum operations
-            if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
-                action == parameters_.MAX_VELOCITY_OTHER) {
-                return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
-            } else if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
-                        action == parameters_.MIN_VELOCITY_OTHER ) {
-                return prob_between(gap_error_max, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
-            } else {
-                return single_sample_prob;
-            }
-        // For both desired gap boundaries the gap error is positive (gap boundaries are ordered)
-        } else if (gap_error_min < 0 && gap_error_max < 0 &&
-            action <= std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) &&
-            action >= std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER) ) {
-            // Consider boundaries due to maximum and minimum operations
-            if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
-                    gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
-                    action == parameters_.MAX_VELOCITY_OTHER) {
+    // For both boundaries of gap range gap error is negative 
+    if(gap_error_min < 0 && gap_error_max <= 0 &&
+        action <= std::max(gap_error_min, parameters_.MIN_VELOCITY_OTHER) &&
+            action >= std::max(gap_error_max, parameters_.MIN_VELOCITY_OTHER) ) {
+                // Consider boundaries due to maximum and minimum operations
+            if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
+            gap_error_min < parameters_.MIN_VELOCITY_OTHER &&
+                action == parameters_.MIN_VELOCITY_OTHER) {
                 return one_prob;
-            } else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
-                    action == parameters_.MAX_VELOCITY_OTHER) {
-                return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
-            } else if(gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
-                    action == parameters_.MAX_VELOCITY_OTHER) {
-                return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_max, uniform_prob);
+            } else if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
+                action == parameters_.MIN_VELOCITY_OTHER) {
+                    return prob_between(gap_error_max, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
+                } else if(gap_error_min < parameters_.MIN_VELOCITY_OTHER &&
+                action == parameters_.MIN_VELOCITY_OTHER) {
+                    return prob_between(gap_error_min, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
             } else {
-                return single_sample_prob;
+                    return single_sample_prob;
             }
+    // For only the higher desired gap the gap error is negative -> 
+    } else if(gap_error_min >= 0 && gap_error_max <= 0 &&
+        action <= std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) &&
+        action >= std::max(gap_error_max, parameters_.MIN_VELOCITY_OTHER) ) 
+    {
+        // Consider boundaries due to maximum and minimum operations
+        if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
+            action == parameters_.MAX_VELOCITY_OTHER) {
+            return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
+        } else if(gap_error_max < parameters_.MIN_VELOCITY_OTHER &&
+                    action == parameters_.MIN_VELOCITY_OTHER ) {
+            return prob_between(gap_error_max, parameters_.MIN_VELOCITY_OTHER, uniform_prob);
         } else {
-            return zero_prob;
+            return single_sample_prob;
         }
-    };
-    
-    // Lambda function to calculate probabilities for negative gap errors
-    auto probability_negative_gap_error = [&](const float gap_error_min, const float gap_error_max,
-                                              const float uniform_prob, const float single_sample_prob)
-                                              -> Probability {
-                                                
-        if(action >= std::max(std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action) &&
-        action <= std::max(std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action) ) {
-            // first check if action can only come up by using last action
-            if (agent_state.last_action == action &&
-                    std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) <= agent_state.last_action &&
-                    std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER) <= agent_state.last_action) {
-                return one_prob;
-            }
-            // then resolve inner max operations, first if we took the last action ...
-            else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
+    // For both desired gap boundaries the gap error is positive (gap boundaries are ordered)
+    } else if (gap_error_min < 0 && gap_error_max < 0 &&
+        action <= std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) &&
+        action >= std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER) ) {
+        // Consider boundaries due to maximum and minimum operations
+        if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
                 gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
                 action == parameters_.MAX_VELOCITY_OTHER) {
-                return one_prob;
-            } else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
-                        gap_error_max < parameters_.MAX_VELOCITY_OTHER &&
-                    action == parameters_.MAX_VELOCITY_OTHER) {
-                return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
-            } else if(gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
-                        gap_error_min < parameters_.MAX_VELOCITY_OTHER &&
-                    action == parameters_.MAX_VELOCITY_OTHER) {
-                return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_max, uniform_prob);
-            } else {
-                return single_sample_prob;  
-            }
+            return one_prob;
+        } else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
+                action == parameters_.MAX_VELOCITY_OTHER) {
+            return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
+        } else if(gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
+                action == parameters_.MAX_VELOCITY_OTHER) {
+            return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_max, uniform_prob);
         } else {
-                return zero_prob;
+            return single_sample_prob;
         }
-    }; 
-        
+    } else {
+        return zero_prob;
+    }
+}
+
+template <>
+inline Probability AgentPolicyCrossingState<float>::probability_negative_gap_error(const AgentState<float>& agent_state,
+                                                    const float& action, const float gap_error_min, const float gap_error_max,
+                                                    const float uniform_prob, const float single_sample_prob) const {
+    auto prob_between = [&](float left, float right, float uniform_prob) -> Probability {
+        return std::max(right - left, gap_discretization()) * uniform_prob;
+    };
+    const Probability zero_prob = 0.0f;
+    const Probability one_prob = 1.0f;
+
+    if(action >= std::max(std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action) &&
+    action <= std::max(std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action) ) {
+        // first check if action can only come up by using last action
+        if (agent_state.last_action == action &&
+                std::min(gap_error_min, parameters_.MAX_VELOCITY_OTHER) <= agent_state.last_action &&
+                std::min(gap_error_max, parameters_.MAX_VELOCITY_OTHER) <= agent_state.last_action) {
+            return one_prob;
+        }
+        // then resolve inner max operations, first if we took the last action ...
+        else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
+            gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
+            action == parameters_.MAX_VELOCITY_OTHER) {
+            return one_prob;
+        } else if(gap_error_min > parameters_.MAX_VELOCITY_OTHER &&
+                    gap_error_max < parameters_.MAX_VELOCITY_OTHER &&
+                action == parameters_.MAX_VELOCITY_OTHER) {
+            return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_min, uniform_prob);
+        } else if(gap_error_max > parameters_.MAX_VELOCITY_OTHER &&
+                    gap_error_min < parameters_.MAX_VELOCITY_OTHER &&
+                action == parameters_.MAX_VELOCITY_OTHER) {
+            return prob_between(parameters_.MAX_VELOCITY_OTHER, gap_error_max, uniform_prob);
+        } else {
+            return single_sample_prob;  
+        }
+    } else {
+            return zero_prob;
+    }
+}
+
+template <>
+inline Probability AgentPolicyCrossingState<float>::get_probability(const AgentState<float>& agent_state, const AgentState<float>& ego_state, const float& action) const {
+    MCTS_EXPECT_TRUE((desired_gap_range_.second-desired_gap_range_.first) > gap_discretization());
     // Distinguish between the different cases 
     if(agent_state.x_pos < parameters_.CROSSING_POINT() ) {
         const auto gap_error_min = ego_state.x_pos + ego_state.last_action - agent_state.x_pos - desired_gap_range_.first;
         const auto gap_error_max = ego_state.x_pos + ego_state.last_action - agent_state.x_pos - desired_gap_range_.second;
         const auto gap_error_desired_gap_zero = ego_state.x_pos + ego_state.last_action - agent_state.x_pos;
-        if ( desired_gap_range_.first >= 0 && desired_gap_range_.second > 0) {
-            const Probability uniform_prob = 1/std::abs(desired_gap_range_.second-desired_gap_range_.first);
-            const Probability single_sample_prob = uniform_prob * gap_discretization;
-            return probability_positive_gap_error(gap_error_min, gap_error_max, uniform_prob, single_sample_prob);
-        } else if(desired_gap_range_.first < 0 && desired_gap_range_.second <= 0) {
-            const Probability uniform_prob = 1/std::abs(desired_gap_range_.second-desired_gap_range_.first);
-            const Probability single_sample_prob = uniform_prob * gap_discretization;
-            return probability_negative_gap_error(gap_error_min, gap_error_max, uniform_prob, single_sample_prob);
-        } else if(desired_gap_range_.first < 0 && desired_gap_range_.second > 0) {
-            // Split up gap range into negative and positive part and combine with probability OR
-            const Probability uniform_prob_pos_range = 1/desired_gap_range_.second;
-            const Probability uniform_prob_neg_range = 1/-desired_gap_range_.first;
-            const Probability single_sample_prob_pos_range = uniform_prob_pos_range * gap_discretization;
-            const Probability single_sample_prob_neg_range = uniform_prob_neg_range * gap_discretization;
-            const Probability negative_range_prob = (-desired_gap_range_.first)/std::abs(desired_gap_range_.second-desired_gap_range_.first);
-            const Probability positive_range_prob = (desired_gap_range_.second)/std::abs(desired_gap_range_.second-desired_gap_range_.first);
-            
-            const Probability p_negative_gap = probability_negative_gap_error(
-                gap_error_min, gap_error_desired_gap_zero, uniform_prob_neg_range, single_sample_prob_neg_range
-            );
-            const Probability p_positive_gap = probability_positive_gap_error(
-                gap_error_desired_gap_zero, gap_error_max, uniform_prob_pos_range, single_sample_prob_pos_range
-            );
-            return p_negative_gap*negative_range_prob + p_positive_gap*positive_range_prob;
-        } else {
-            throw "invalid configuration of desired gap range.";
+        const auto& constants = gap_range_constants_;
+        switch(gap_range_type_) {
+            case POSITIVE_GAP_RANGE:
+                return probability_positive_gap_error(action, gap_error_min, gap_error_max,
+                                                      constants.uniform_prob_pos_range, constants.single_sample_prob_pos_range);
+            case NEGATIVE_GAP_RANGE:
+                return probability_negative_gap_error(agent_state, action, gap_error_min, gap_error_max,
+                                                      constants.uniform_prob_neg_range, constants.single_sample_prob_neg_range);
+            case MIXED_GAP_RANGE: {
+                const Probability p_negative_gap = probability_negative_gap_error(agent_state, action,
+                    gap_error_min, gap_error_desired_gap_zero, constants.uniform_prob_neg_range, constants.single_sample_prob_neg_range
+                );
+                const Probability p_positive_gap = probability_positive_gap_error(action,
+                    gap_error_desired_gap_zero, gap_error_max, constants.uniform_prob_pos_range, constants.single_sample_prob_pos_range
+                );
+                return p_negative_gap*constants.negative_range_prob + p_positive_gap*constants.positive_range_prob;
+            }
+            default:
+                throw "invalid configuration of desired gap range.";
         }
     } else {
         if(action == agent_state.last_action) {
-            return one_prob;
+            return 1.0f;
         } else {
-            return zero_prob;
+            return 0.0f;
         }
     }
 }
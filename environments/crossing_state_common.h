@@ -8,8 +8,15 @@
 #ifndef MCTS_CROSSING_STATE_COMMON_H_
 #define MCTS_CROSSING_STATE_COMMON_H_
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
 #include "environments/crossing_state_parameters.h"
 #include "mcts/hypothesis/hypothesis_state.h"
+#include "mcts/object_pool.h"
 
 namespace mcts {
 
@@ -26,6 +33,21 @@ inline ActionIdx aconv(const Domain& action) {
     return ((union { Domain i; ActionIdx u; }){ .i = action }).u;
 }
 
+// Zobrist key of a feature value. Keys are derived by a bit mixer instead of a random table,
+// such that unbounded integer and floating point values need no discretization.
+template <typename Domain>
+inline std::size_t zobrist_key(const std::size_t& feature, const Domain& value) {
+    static_assert(sizeof(Domain) <= sizeof(std::uint32_t), "Feature values must fit into 32 bits");
+    const Domain normalized = (value == 0) ? Domain(0) : value; // equal values have equal bits, e.g. -0.0f
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &normalized, sizeof(Domain));
+    // splitmix64 finalizer
+    std::uint64_t key = ((static_cast<std::uint64_t>(feature) << 32) | bits) + 0x9e3779b97f4a7c15ull;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<std::size_t>(key ^ (key >> 31));
+}
+
 template <typename Domain>
 struct AgentState {
     AgentState() : x_pos(5), last_action(2.0f) {}
@@ -35,6 +57,42 @@ struct AgentState {
     Domain last_action;
 };
 
+// Number of other agents only known at runtime, given by CrossingStateParameters::NUM_OTHER_AGENTS
+constexpr std::size_t DYNAMIC_NUM_AGENTS = std::numeric_limits<std::size_t>::max();
+
+// Per agent values of the other agents, a fixed size array if the number of agents is known at compile time.
+// Otherwise the values are stored in buffers drawn from the given pool, or from the heap without a pool.
+template <typename Domain, std::size_t NumOtherAgents>
+struct AgentArray {
+    typedef std::array<Domain, NumOtherAgents> type;
+
+    static type make(const std::size_t& num_agents, const Domain& value = Domain(),
+                     const std::shared_ptr<BlockPool>& = nullptr) {
+        MCTS_EXPECT_TRUE(num_agents == NumOtherAgents);
+        type values;
+        values.fill(value);
+        return values;
+    }
+
+    static type copy(const type& values, const std::shared_ptr<BlockPool>&) {
+        return values;
+    }
+};
+
+template <typename Domain>
+struct AgentArray<Domain, DYNAMIC_NUM_AGENTS> {
+    typedef std::vector<Domain, PoolAllocator<Domain>> type;
+
+    static type make(const std::size_t& num_agents, const Domain& value = Domain(),
+                     const std::shared_ptr<BlockPool>& pool = nullptr) {
+        return type(num_agents, value, PoolAllocator<Domain>(pool));
+    }
+
+    static type copy(const type& values, const std::shared_ptr<BlockPool>& pool) {
+        return type(values.begin(), values.end(), PoolAllocator<Domain>(pool));
+    }
+};
+
 } // namespace mcts
 
 #endif
\ No newline at end of file
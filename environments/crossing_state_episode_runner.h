@@ -17,9 +17,13 @@
 
 namespace mcts {
 
-template<typename Domain>
+// The heuristic is constructed from the runner's parameters and the optional trailing constructor arguments
+template<typename Domain, class H = RandomHeuristic, std::size_t NumOtherAgents = DYNAMIC_NUM_AGENTS>
 class CrossingStateEpisodeRunner {
   public:
+    using State = CrossingState<Domain, NumOtherAgents>;
+
+    template<class... HeuristicArgs>
     CrossingStateEpisodeRunner(const std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>>& agents_true_policies,
                               const std::vector<AgentPolicyCrossingState<Domain>>& hypothesis,
                               const MctsParameters& mcts_parameters,
@@ -27,17 +31,21 @@ class CrossingStateEpisodeRunner {
                               const unsigned int& max_steps,
                               const unsigned int& mcts_max_search_time,
                               const unsigned int& mcts_max_iterations,
-                              Viewer* viewer) :
-                  agents_true_policies_(agents_true_policies),
+                              Viewer* viewer,
+                              HeuristicArgs&&... heuristic_args) :
+                  viewer_(viewer),
                   current_state_(),
                   last_state_(),
                   belief_tracker_(mcts_parameters),
+                  agents_true_policies_(agents_true_policies),
+                  true_policies_random_stream_(crossing_state_parameters.OTHER_AGENTS_POLICY_RANDOM_SEED),
                   max_steps_(max_steps),
                   mcts_parameters_(mcts_parameters),
                   crossing_state_parameters_(crossing_state_parameters),
-                  viewer_(viewer)  {
-                  current_state_ = std::make_shared<CrossingState<Domain>>(belief_tracker_.sample_current_hypothesis(),
-                                                                           crossing_state_parameters_);
+                  heuristic_(mcts_parameters_, std::forward<HeuristicArgs>(heuristic_args)...),
+                  mcts_()  {
+                  current_state_ = std::make_shared<State>(belief_tracker_.sample_current_hypothesis(),
+                                                           crossing_state_parameters_);
                   for(const auto& hp : hypothesis) {
                     current_state_->add_hypothesis(hp);
                   }
@@ -46,6 +54,10 @@ class CrossingStateEpisodeRunner {
                   belief_tracker_.belief_update(*last_state_, *current_state_);
                   }
 
+    // The heuristic refers to the parameters of the runner, copies would refer to the parameters of the original
+    CrossingStateEpisodeRunner(const CrossingStateEpisodeRunner&) = delete;
+    CrossingStateEpisodeRunner& operator=(const CrossingStateEpisodeRunner&) = delete;
+
     std::tuple<std::pair<std::string, float>,std::pair<std::string, float>,
                             std::pair<std::string, bool>, std::pair<std::string, bool>,
                             std::pair<std::string, bool>> step() {
@@ -58,15 +70,17 @@ class CrossingStateEpisodeRunner {
       Cost cost;
 
       JointAction jointaction(current_state_->get_num_agents());
-      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_parameters_);
-      mcts.search(*current_state_, belief_tracker_);
-      jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+      if(!mcts_ || mcts_parameters_.REUSE_TREE_ITERATIONS == 0) {
+        mcts_ = std::make_unique<EpisodeMcts>(mcts_parameters_, heuristic_);
+      }
+      mcts_->search(*current_state_, belief_tracker_);
+      jointaction[State::ego_agent_idx] = mcts_->returnBestAction();
 
       AgentIdx action_idx = 1;
-      for (auto agent_idx : current_state_->get_other_agent_idx()) {
+      for (auto agent_idx : current_state_->get_other_agent_idx_range()) {
           // Other agents act according to unknown true agents policy
           const auto action = agents_true_policies_.at(agent_idx).act(current_state_->get_agent_state(agent_idx),
-                                                      current_state_->get_ego_state());
+                                                      current_state_->get_ego_state(), true_policies_random_stream_);
           jointaction[action_idx] = aconv(action);
           action_idx++;
       }
@@ -74,6 +88,10 @@ class CrossingStateEpisodeRunner {
       last_state_ = current_state_;
       current_state_ = last_state_->execute(jointaction, rewards, cost);
       belief_tracker_.belief_update(*last_state_, *current_state_);
+      if(mcts_parameters_.REUSE_TREE_ITERATIONS > 0 && mcts_->reroot(jointaction)) {
+        // The next search tops up the statistics of the executed joint action under the updated beliefs
+        mcts_->prune_hypotheses(belief_tracker_);
+      }
       
       bool collision = current_state_->ego_collided();
       bool goal_reached = current_state_->ego_goal_reached();
@@ -89,7 +107,7 @@ class CrossingStateEpisodeRunner {
 
       return std::tuple<std::pair<std::string, float>,std::pair<std::string, float>,
                             std::pair<std::string, bool>, std::pair<std::string, bool>,
-                            std::pair<std::string, bool>> (std::pair<std::string, float>(std::string("Reward"), rewards[CrossingState<Domain>::ego_agent_idx]), 
+                            std::pair<std::string, bool>> (std::pair<std::string, float>(std::string("Reward"), rewards[State::ego_agent_idx]), 
                                                              std::pair<std::string, float>(std::string("Cost"), cost),
                                                              std::pair<std::string, bool>(std::string("Terminal"), std::move(current_state_->is_terminal())),
                                                              std::pair<std::string, bool>(std::string("Collision"), std::move(collision)),
@@ -126,14 +144,19 @@ class CrossingStateEpisodeRunner {
     }
 
   private:
+    using EpisodeMcts = Mcts<State, UctStatistic, HypothesisStatistic, H>;
+
     Viewer* viewer_;
-    std::shared_ptr<CrossingState<Domain>> current_state_;
-    std::shared_ptr<CrossingState<Domain>> last_state_;
-    HypothesisBeliefTracker belief_tracker_; // todo: pass params
+    std::shared_ptr<State> current_state_;
+    std::shared_ptr<State> last_state_;
+    HypothesisBeliefTracker belief_tracker_;
     std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>> agents_true_policies_;
+    typename AgentPolicyCrossingState<Domain>::RandomStream true_policies_random_stream_; // drawn in order of the agents
     const unsigned int max_steps_;
     const MctsParameters mcts_parameters_;
     const CrossingStateParameters<Domain> crossing_state_parameters_;
+    const H heuristic_; // refers to mcts_parameters_
+    std::unique_ptr<EpisodeMcts> mcts_; // kept across steps if the tree is reused
 };
 
 
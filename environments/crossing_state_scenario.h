@@ -0,0 +1,93 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+
+#ifndef MCTS_CROSSING_STATE_SCENARIO_H_
+#define MCTS_CROSSING_STATE_SCENARIO_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "environments/crossing_state_parameters.h"
+#include "environments/crossing_state_agent_policy.h"
+
+namespace mcts {
+
+// Synthetic crossing scenarios of arbitrary size, e.g. for benchmarks. All parts are generated from a seed
+// with std::mt19937, whose output is fixed by the standard. Values are derived from it directly as the
+// mapping of the standard distributions differs between implementations, equal arguments thus yield
+// equal scenarios on all platforms.
+
+// Bounds of the generated desired gap ranges, ranges of the default hypotheses lie within
+const int SCENARIO_MIN_DESIRED_GAP = -2;
+const int SCENARIO_MAX_DESIRED_GAP = 6;
+const int SCENARIO_MAX_DESIRED_GAP_WIDTH = 2;
+
+// Uniform index below range by Lemire's multiply-shift method, rejecting the biased part of the output
+inline std::uint32_t scenario_uniform_index(std::mt19937& random_generator, const std::uint32_t& range) {
+  MCTS_EXPECT_TRUE(range > 0);
+  std::uint64_t product = static_cast<std::uint64_t>(random_generator()) * range;
+  if (static_cast<std::uint32_t>(product) < range) {
+    const std::uint32_t threshold = static_cast<std::uint32_t>(0u - range) % range; // 2^32 mod range
+    while (static_cast<std::uint32_t>(product) < threshold) {
+      product = static_cast<std::uint64_t>(random_generator()) * range;
+    }
+  }
+  return static_cast<std::uint32_t>(product >> 32);
+}
+
+template <typename Domain>
+CrossingStateParameters<Domain> crossing_state_scenario_parameters(const unsigned int& num_other_agents,
+                                                                  const Domain& chain_length,
+                                                                  const unsigned int& seed) {
+  auto parameters = default_crossing_state_parameters<Domain>();
+  parameters.NUM_OTHER_AGENTS = num_other_agents;
+  parameters.OTHER_AGENTS_POLICY_RANDOM_SEED = seed;
+  parameters.CHAIN_LENGTH = chain_length;
+  parameters.EGO_GOAL_POS = parameters.CROSSING_POINT() + 1;
+  MCTS_EXPECT_TRUE(parameters.EGO_GOAL_POS < chain_length);
+  return parameters;
+}
+
+// The policies refer to the given parameters
+template <typename Domain>
+std::vector<AgentPolicyCrossingState<Domain>> crossing_state_scenario_hypothesis(
+                                                    const CrossingStateParameters<Domain>& parameters,
+                                                    const unsigned int& num_hypothesis,
+                                                    const unsigned int& seed) {
+  std::mt19937 random_generator(seed);
+  std::vector<AgentPolicyCrossingState<Domain>> hypothesis;
+  hypothesis.reserve(num_hypothesis);
+  for (unsigned int i = 0; i < num_hypothesis; ++i) {
+    const int min_gap = SCENARIO_MIN_DESIRED_GAP + static_cast<int>(scenario_uniform_index(random_generator,
+                                                    SCENARIO_MAX_DESIRED_GAP - SCENARIO_MIN_DESIRED_GAP + 1));
+    const int width = static_cast<int>(scenario_uniform_index(random_generator, SCENARIO_MAX_DESIRED_GAP_WIDTH + 1));
+    const int max_gap = std::min(min_gap + width, SCENARIO_MAX_DESIRED_GAP);
+    hypothesis.emplace_back(std::make_pair(static_cast<Domain>(min_gap), static_cast<Domain>(max_gap)), parameters);
+  }
+  return hypothesis;
+}
+
+// Each other agent acts by one of the hypotheses, such that the true policies are contained in the hypothesis set
+template <typename Domain>
+std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>> crossing_state_scenario_true_policies(
+                                                    const CrossingStateParameters<Domain>& parameters,
+                                                    const std::vector<AgentPolicyCrossingState<Domain>>& hypothesis,
+                                                    const unsigned int& seed) {
+  MCTS_EXPECT_TRUE(!hypothesis.empty());
+  std::mt19937 random_generator(seed);
+  std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>> true_policies;
+  for (AgentIdx agent_idx = 1; agent_idx <= parameters.NUM_OTHER_AGENTS; ++agent_idx) { // 0 is ego agent
+    true_policies.emplace(agent_idx, hypothesis[scenario_uniform_index(random_generator, hypothesis.size())]);
+  }
+  return true_policies;
+}
+
+} // namespace mcts
+
+#endif // MCTS_CROSSING_STATE_SCENARIO_H_
@@ -229,6 +229,8 @@ TEST(hypothesis_crossing_state_float, hypothesis_friendly)
     std::vector<Reward> rewards;
     Cost cost;
     bool collision = false;
+    RandomStream random_stream(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    RandomStreamScope random_stream_scope(random_stream);
 
     // Ego agent moves forward other agents stick to deterministic hypothesis keeping distance of 5
     for(int i = 0; i< 100; ++i) {
@@ -272,6 +274,7 @@ TEST(hypothesis_crossing_state_float, hypothesis_belief_correct)
     auto next_state = state;
 
     AgentPolicyCrossingState<Domain> true_agents_policy({0.3, 0.7}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -284,7 +287,8 @@ TEST(hypothesis_crossing_state_float, hypothesis_belief_correct)
       AgentIdx action_idx = 1;
       for (auto agent_idx : state->get_other_agent_idx()) {
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(),
+                                                    true_agents_random_generator);
         jointaction[action_idx] = aconv<Domain>(action);
         action_idx++;
       }
@@ -319,6 +323,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({2,3.5}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -336,7 +341,8 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
         for (auto agent_idx : state->get_other_agent_idx()) {
           // Other agents act according to unknown true agents policy
           const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                      state->get_ego_state());
+                                                      state->get_ego_state(),
+                                                      true_agents_random_generator);
           jointaction[agent_idx] = aconv<Domain>(action);
           action_idx++;
       }
@@ -365,6 +371,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({-2,-1.8}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -381,7 +388,8 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(),
+                                                    true_agents_random_generator);
         jointaction[action_idx] = aconv<Domain>(action);
         action_idx++;
       }
@@ -407,7 +415,7 @@ TEST(episode_runner, four_agents_reached_goal) {
   params.NUM_OTHER_AGENTS = 4;
   params.CHAIN_LENGTH = 41;
   params.EGO_GOAL_POS = 26;
-  auto runner = CrossingStateEpisodeRunner<Domain>(
+  CrossingStateEpisodeRunner<Domain> runner(
       { {1 , AgentPolicyCrossingState<Domain>({5,6}, params)},
         {2 , AgentPolicyCrossingState<Domain>({3,4}, params)},
         {3 , AgentPolicyCrossingState<Domain>({5.5,6}, params)},
@@ -427,7 +435,7 @@ TEST(episode_runner, four_agents_reached_goal) {
 
 TEST(episode_runner, collision_return_true) {
   auto params = default_crossing_state_parameters<Domain>();
-  auto runner = CrossingStateEpisodeRunner<Domain>(
+  CrossingStateEpisodeRunner<Domain> runner(
       { {1 , AgentPolicyCrossingState<Domain>({-0.01,0.01}, params)},
         {2 , AgentPolicyCrossingState<Domain>({-0.01,0.01}, params)}},
       {AgentPolicyCrossingState<Domain>({3,4}, params), 
@@ -445,7 +453,7 @@ TEST(episode_runner, collision_return_true) {
 
 TEST(episode_runner, run_some_steps) {
   const auto params = default_crossing_state_parameters<Domain>();
-  auto runner = CrossingStateEpisodeRunner<Domain>(
+  CrossingStateEpisodeRunner<Domain> runner(
       { {1 , AgentPolicyCrossingState<Domain>({-0.01,0.01}, params)},
         {2 , AgentPolicyCrossingState<Domain>({-0.01,0.01}, params)}},
       {AgentPolicyCrossingState<Domain>({4,5}, params), 
@@ -17,8 +17,12 @@
 
 #include "environments/crossing_state.h"
 #include "environments/crossing_state_episode_runner.h"
+#include "environments/crossing_state_scenario.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <future>
+#include <mutex>
 
 using namespace std;
 using namespace mcts;
@@ -57,6 +61,158 @@ TEST(hypothesis_crossing_state, collision )
     EXPECT_TRUE(collision);
 }
 
+TEST(hypothesis_crossing_state, execute_many_agents)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 150;
+    HypothesisContext context;
+    std::vector<AgentState<Domain>> agent_states;
+    for (unsigned int i = 0; i < params.NUM_OTHER_AGENTS; ++i) {
+      agent_states.emplace_back(i % params.CHAIN_LENGTH, 0);
+    }
+    const AgentState<Domain> ego_state(params.CROSSING_POINT() - 1, 0);
+    const CrossingState<Domain> state(context, params, agent_states, ego_state, false, false, false,
+                                      std::vector<AgentPolicyCrossingState<Domain>>());
+
+    JointAction jointaction(state.get_num_agents());
+    jointaction[CrossingState<Domain>::ego_agent_idx] = 0; // ego moves back from the crossing point
+    for (auto agent_idx : state.get_other_agent_idx()) {
+      jointaction[agent_idx] = aconv<Domain>(static_cast<Domain>(agent_idx % 5) - 2);
+    }
+    std::vector<Reward> rewards;
+    Cost cost;
+    const auto next_state = state.execute(jointaction, rewards, cost);
+    EXPECT_EQ(rewards.size(), state.get_num_agents());
+    EXPECT_FALSE(next_state->ego_collided());
+    for (auto agent_idx : state.get_other_agent_idx()) {
+      const Domain action = aconv<Domain>(jointaction[agent_idx]);
+      const Domain new_x = agent_states[agent_idx-1].x_pos + action;
+      EXPECT_EQ(next_state->get_agent_state(agent_idx).x_pos, new_x >= 0 ? new_x : 0);
+      EXPECT_EQ(next_state->get_last_action(agent_idx), action);
+    }
+
+    // Any agent crossing together with the ego agent collides
+    jointaction[CrossingState<Domain>::ego_agent_idx] = 2 - params.MIN_VELOCITY_EGO;
+    EXPECT_TRUE(state.execute(jointaction, rewards, cost)->ego_collided());
+}
+
+TEST(hypothesis_crossing_state, incremental_hash_equals_recomputed)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 5;
+    HypothesisContext context;
+    auto state = std::make_shared<CrossingState<Domain>>(context, params);
+    EXPECT_TRUE(is_hashable_state<CrossingState<Domain>>::value);
+
+    std::mt19937 random_generator(1000);
+    std::uniform_int_distribution<Domain> other_action(params.MIN_VELOCITY_OTHER, params.MAX_VELOCITY_OTHER);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for (int i = 0; i < 10 && !state->is_terminal(); ++i) {
+      JointAction jointaction(state->get_num_agents());
+      jointaction[CrossingState<Domain>::ego_agent_idx] = i % 2; // ego stays in the map
+      for (auto agent_idx : state->get_other_agent_idx_range()) {
+        jointaction[agent_idx] = aconv<Domain>(other_action(random_generator));
+      }
+      state = state->execute(jointaction, rewards, cost);
+      const CrossingState<Domain> recomputed(context, params, state->get_agent_states(), state->get_ego_state(),
+                                             state->is_terminal(), state->ego_goal_reached(), state->ego_collided(),
+                                             std::vector<AgentPolicyCrossingState<Domain>>());
+      EXPECT_EQ(state->hash(), recomputed.hash());
+      EXPECT_TRUE(state->equals(recomputed));
+    }
+
+    // Different positions are distinguished
+    std::vector<AgentState<Domain>> agent_states = state->get_agent_states();
+    agent_states[2].x_pos += 1;
+    const CrossingState<Domain> moved(context, params, agent_states, state->get_ego_state(), state->is_terminal(),
+                                      state->ego_goal_reached(), state->ego_collided(),
+                                      std::vector<AgentPolicyCrossingState<Domain>>());
+    EXPECT_NE(state->hash(), moved.hash());
+    EXPECT_FALSE(state->equals(moved));
+}
+
+TEST(hypothesis_crossing_state, fixed_num_agents_equals_dynamic)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 4;
+    HypothesisContext context;
+    auto state = std::make_shared<CrossingState<Domain>>(context, params);
+    auto fixed_state = std::make_shared<CrossingState<Domain, 4>>(context, params);
+    EXPECT_EQ(fixed_state->get_num_agents(), state->get_num_agents());
+
+    std::mt19937 random_generator(1000);
+    std::uniform_int_distribution<Domain> other_action(params.MIN_VELOCITY_OTHER, params.MAX_VELOCITY_OTHER);
+    std::vector<Reward> rewards, fixed_rewards;
+    Cost cost, fixed_cost;
+    for (int i = 0; i < 20 && !state->is_terminal(); ++i) {
+      JointAction jointaction(state->get_num_agents());
+      jointaction[CrossingState<Domain>::ego_agent_idx] = (i % 3) + 1;
+      for (auto agent_idx : state->get_other_agent_idx_range()) {
+        jointaction[agent_idx] = aconv<Domain>(other_action(random_generator));
+      }
+      state = state->execute(jointaction, rewards, cost);
+      fixed_state = fixed_state->execute(jointaction, fixed_rewards, fixed_cost);
+      EXPECT_EQ(fixed_rewards, rewards);
+      EXPECT_EQ(fixed_cost, cost);
+      EXPECT_EQ(fixed_state->hash(), state->hash());
+      EXPECT_EQ(fixed_state->is_terminal(), state->is_terminal());
+      EXPECT_EQ(fixed_state->ego_collided(), state->ego_collided());
+      EXPECT_EQ(fixed_state->get_ego_state().x_pos, state->get_ego_state().x_pos);
+      for (auto agent_idx : state->get_other_agent_idx_range()) {
+        EXPECT_EQ(fixed_state->get_agent_state(agent_idx).x_pos, state->get_agent_state(agent_idx).x_pos);
+        EXPECT_EQ(fixed_state->get_last_action(agent_idx), state->get_last_action(agent_idx));
+      }
+    }
+}
+
+TEST(crossing_state_scenario, uniform_index_fixed_by_engine_output)
+{
+    // Indices only depend on the output of std::mt19937, which is fixed by the standard
+    std::mt19937 random_generator(1000);
+    std::vector<std::uint32_t> indices;
+    for (int i = 0; i < 8; ++i) {
+      indices.push_back(scenario_uniform_index(random_generator, 9));
+    }
+    EXPECT_EQ(indices, (std::vector<std::uint32_t>{5, 1, 1, 5, 8, 0, 4, 3}));
+
+    std::vector<unsigned int> counts(3, 0);
+    for (int i = 0; i < 30000; ++i) {
+      counts[scenario_uniform_index(random_generator, 3)] += 1;
+    }
+    for (const auto& count : counts) {
+      EXPECT_NEAR(count, 10000, 300);
+    }
+}
+
+TEST(crossing_state_scenario, generated_from_seed)
+{
+    const auto params = crossing_state_scenario_parameters<Domain>(20, 81, 1000);
+    EXPECT_EQ(params.NUM_OTHER_AGENTS, 20);
+    EXPECT_GT(params.EGO_GOAL_POS, params.CROSSING_POINT());
+    EXPECT_LT(params.EGO_GOAL_POS, params.CHAIN_LENGTH);
+
+    const auto hypothesis = crossing_state_scenario_hypothesis(params, 50, 1000);
+    const auto same_hypothesis = crossing_state_scenario_hypothesis(params, 50, 1000);
+    const auto other_hypothesis = crossing_state_scenario_hypothesis(params, 50, 1001);
+    ASSERT_EQ(hypothesis.size(), 50);
+    bool other_seed_differs = false;
+    for (std::size_t i = 0; i < hypothesis.size(); ++i) {
+      EXPECT_EQ(hypothesis[i].info(), same_hypothesis[i].info());
+      other_seed_differs |= hypothesis[i].info() != other_hypothesis[i].info();
+    }
+    EXPECT_TRUE(other_seed_differs);
+
+    // True policies are drawn from the hypothesis set
+    const auto true_policies = crossing_state_scenario_true_policies(params, hypothesis, 1000);
+    ASSERT_EQ(true_policies.size(), params.NUM_OTHER_AGENTS);
+    for (AgentIdx agent_idx = 1; agent_idx <= params.NUM_OTHER_AGENTS; ++agent_idx) {
+      const auto info = true_policies.at(agent_idx).info();
+      EXPECT_TRUE(std::any_of(hypothesis.begin(), hypothesis.end(),
+                              [&info](const AgentPolicyCrossingState<Domain>& hp) { return hp.info() == info; }));
+    }
+}
+
 TEST(hypothesis_crossing_state, hypothesis_friendly)
 {
     const auto params = default_crossing_state_parameters<Domain>();
@@ -70,6 +226,8 @@ TEST(hypothesis_crossing_state, hypothesis_friendly)
     std::vector<Reward> rewards;
     Cost cost;
     bool collision = false;
+    RandomStream random_stream(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    RandomStreamScope random_stream_scope(random_stream);
 
     // Ego agent moves forward other agents stick to deterministic hypothesis keeping distance of 5
     for(int i = 0; i< 100; ++i) {
@@ -106,6 +264,7 @@ TEST(hypothesis_crossing_state, hypothesis_belief_correct)
     auto next_state = state;
 
     AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -117,7 +276,8 @@ TEST(hypothesis_crossing_state, hypothesis_belief_correct)
       jointaction[CrossingState<Domain>::ego_agent_idx] =  2;
       for (auto agent_idx : state->get_other_agent_idx()) {
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(),
+                                                    true_agents_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -137,8 +297,412 @@ TEST(hypothesis_crossing_state, hypothesis_belief_correct)
 }
 
 
+TEST(hypothesis_crossing_state, probability_table_equals_enumeration)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    for (const auto& gap_range : std::vector<std::pair<int, int>>{{5,5}, {4,5}, {-2,-2}, {-3,3}, {2,8}}) {
+      AgentPolicyCrossingState<Domain> policy(gap_range, params);
+      for (int agent_x = 0; agent_x <= params.CROSSING_POINT(); ++agent_x) {
+        for (int ego_x = 0; ego_x < params.CHAIN_LENGTH; ++ego_x) {
+          for (int last_action = params.MIN_VELOCITY_OTHER - 1; last_action <= params.MAX_VELOCITY_OTHER + 1; ++last_action) {
+            const AgentState<Domain> agent_state(agent_x, last_action);
+            const AgentState<Domain> ego_state(ego_x, 1);
+            for (int action = params.MIN_VELOCITY_OTHER - 1; action <= params.MAX_VELOCITY_OTHER + 1; ++action) {
+              unsigned int action_selected = 0;
+              for (int desired_gap_dst = gap_range.first; desired_gap_dst <= gap_range.second; ++desired_gap_dst) {
+                action_selected += policy.calculate_action(agent_state, ego_state, desired_gap_dst) == action;
+              }
+              const Probability expected = static_cast<float>(action_selected)/static_cast<float>(gap_range.second - gap_range.first + 1);
+              EXPECT_EQ(policy.get_probability(agent_state, ego_state, action), expected);
+            }
+          }
+        }
+      }
+    }
+}
+
+TEST(hypothesis_crossing_state, probability_velocity_range_without_zero)
+{
+    // Calculated actions may lie outside of velocity limits not containing zero
+    for (const auto& velocity_range : std::vector<std::pair<int, int>>{{1,3}, {-3,-1}}) {
+      auto params = default_crossing_state_parameters<Domain>();
+      params.MIN_VELOCITY_OTHER = velocity_range.first;
+      params.MAX_VELOCITY_OTHER = velocity_range.second;
+      params.NUM_OTHER_ACTIONS = params.MAX_VELOCITY_OTHER - params.MIN_VELOCITY_OTHER + 1;
+      for (const auto& gap_range : std::vector<std::pair<int, int>>{{4,5}, {-2,-2}, {-3,3}}) {
+        AgentPolicyCrossingState<Domain> policy(gap_range, params);
+        for (int agent_x = 0; agent_x <= params.CROSSING_POINT(); ++agent_x) {
+          for (int ego_x = 0; ego_x < params.CHAIN_LENGTH; ++ego_x) {
+            for (int last_action = params.MIN_VELOCITY_OTHER; last_action <= params.MAX_VELOCITY_OTHER; ++last_action) {
+              const AgentState<Domain> agent_state(agent_x, last_action);
+              const AgentState<Domain> ego_state(ego_x, 1);
+              Probability probability_sum = 0.0f;
+              for (int action = -params.CHAIN_LENGTH; action <= params.CHAIN_LENGTH; ++action) {
+                unsigned int action_selected = 0;
+                for (int desired_gap_dst = gap_range.first; desired_gap_dst <= gap_range.second; ++desired_gap_dst) {
+                  action_selected += policy.calculate_action(agent_state, ego_state, desired_gap_dst) == action;
+                }
+                const Probability expected = static_cast<float>(action_selected)/static_cast<float>(gap_range.second - gap_range.first + 1);
+                const Probability probability = policy.get_probability(agent_state, ego_state, action);
+                EXPECT_EQ(probability, expected);
+                probability_sum += probability;
+              }
+              EXPECT_NEAR(probability_sum, 1.0f, 0.0001f);
+            }
+          }
+        }
+      }
+    }
+}
+
+TEST(hypothesis_crossing_state, batch_probabilities_equal)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 2;
+    HypothesisContext context;
+    CrossingState<Domain> state(context, params);
+    for (const auto& gap_range : std::vector<std::pair<int, int>>{{5,5}, {4,5}, {-2,-2}, {-3,3}, {2,8}}) {
+      state.add_hypothesis(AgentPolicyCrossingState<Domain>(gap_range, params));
+    }
+
+    std::vector<Probability> probabilities;
+    for (auto agent_idx : state.get_other_agent_idx()) {
+      for (int action = params.MIN_VELOCITY_OTHER - 1; action <= params.MAX_VELOCITY_OTHER + 1; ++action) {
+        state.get_probabilities(agent_idx, action, probabilities);
+        ASSERT_EQ(probabilities.size(), state.get_num_hypothesis(agent_idx));
+        for (HypothesisId hid = 0; hid < probabilities.size(); ++hid) {
+          EXPECT_EQ(probabilities[hid], state.get_probability(hid, agent_idx, action));
+        }
+      }
+    }
+}
+
+TEST(hypothesis_crossing_state, parallel_belief_update_equal)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 4;
+    auto mcts_params = mcts_default_parameters();
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    mcts_params.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS = 3;
+    HypothesisBeliefTracker parallel_belief_tracker(mcts_params);
+
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({4,5}, params));
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({5,6}, params));
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({2,8}, params));
+    belief_tracker.belief_update(*state, *state);
+    parallel_belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 20 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      jointaction[CrossingState<Domain>::ego_agent_idx] = 2;
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                      state->get_ego_state(),
+                                                                      true_agents_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      parallel_belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+      EXPECT_EQ(belief_tracker.get_beliefs(), parallel_belief_tracker.get_beliefs());
+    }
+}
+
+TEST(hypothesis_crossing_state, scoped_random_streams_repeat)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params =mcts_default_parameters();
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,6}, params));
+    belief_tracker.belief_update(*state, *state);
+    belief_tracker.sample_current_hypothesis();
+
+    // Streams with equal seed plan the same sequence of actions for the other agents of a const state
+    const std::shared_ptr<const CrossingState<Domain>> const_state = state;
+    auto planned_actions = [&](const unsigned int& seed) {
+      RandomStream random_stream(seed);
+      RandomStreamScope random_stream_scope(random_stream);
+      std::vector<ActionIdx> actions;
+      for(int i = 0; i< 20; ++i) {
+        for (auto agent_idx : const_state->get_other_agent_idx()) {
+          actions.push_back(const_state->plan_action_current_hypothesis(agent_idx));
+        }
+      }
+      return actions;
+    };
+    EXPECT_EQ(planned_actions(10), planned_actions(10));
+    EXPECT_NE(planned_actions(10), planned_actions(11));
+}
+
+TEST(hypothesis_crossing_state, heuristic_copies_seeded_per_worker)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.random_heuristic.COMMON_RANDOM_NUMBERS = false;
+    mcts_params.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 1;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,6}, params));
+    belief_tracker.belief_update(*state, *state);
+    belief_tracker.sample_current_hypothesis();
+    auto node = std::make_shared<StageNode<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>>(
+                    nullptr, state, JointAction(), 0, mcts_params);
+
+    // Copies of the heuristic reseeded for the same worker repeat their rollouts, other workers do not
+    const RandomHeuristic heuristic(mcts_params);
+    auto rollout_returns = [&](const unsigned int& worker_idx) {
+      RandomHeuristic worker_heuristic(heuristic);
+      worker_heuristic.seed(worker_idx);
+      std::vector<Reward> returns;
+      for(int i = 0; i < 20; ++i) {
+        const auto value = worker_heuristic.calculate_heuristic_values(node);
+        returns.insert(returns.end(), value.returns.begin(), value.returns.end());
+      }
+      return returns;
+    };
+    EXPECT_EQ(rollout_returns(1), rollout_returns(1));
+    EXPECT_NE(rollout_returns(0), rollout_returns(1));
+}
+
+TEST(hypothesis_crossing_state, shared_policy_per_thread_streams)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    const AgentPolicyCrossingState<Domain> policy({-2,6}, params);
+    const AgentState<Domain> agent_state(3, 1);
+    const AgentState<Domain> ego_state(4, 1);
+    using RandomStream = AgentPolicyCrossingState<Domain>::RandomStream;
+
+    auto sampled_actions = [&](const unsigned int& seed) {
+      RandomStream random_stream(seed);
+      std::vector<Domain> actions;
+      for(int i = 0; i < 1000; ++i) {
+        actions.push_back(policy.act(agent_state, ego_state, random_stream));
+      }
+      return actions;
+    };
+
+    // Threads sampling from the same policy with their own streams get the actions of a sequential run
+    std::vector<std::future<std::vector<Domain>>> parallel_actions;
+    for (unsigned int seed = 0; seed < 4; ++seed) {
+      parallel_actions.push_back(std::async(std::launch::async, sampled_actions, seed));
+    }
+    for (unsigned int seed = 0; seed < 4; ++seed) {
+      EXPECT_EQ(parallel_actions[seed].get(), sampled_actions(seed));
+    }
+}
+
+TEST(hypothesis_crossing_state, hypothesis_set_shared_by_successors)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    HypothesisContext context;
+    auto state = std::make_shared<CrossingState<Domain>>(context, params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({4,5}, params));
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,-2}, params));
+
+    std::vector<Reward> rewards;
+    Cost cost;
+    const auto next_state = state->execute(JointAction(state->get_num_agents(), 1), rewards, cost);
+    EXPECT_EQ(next_state->get_hypothesis_set(), state->get_hypothesis_set());
+    EXPECT_EQ(state->clone()->get_hypothesis_set(), state->get_hypothesis_set());
+
+    // Adding a hypothesis afterwards leaves the set of existing successors unchanged
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({2,8}, params));
+    EXPECT_EQ(state->get_num_hypothesis(1), 3);
+    EXPECT_EQ(next_state->get_num_hypothesis(1), 2);
+}
+
+TEST(hypothesis_crossing_state, state_pool_recycles_states)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    HypothesisContext context;
+    const CrossingState<Domain> constructed_state(context, params);
+    EXPECT_FALSE(constructed_state.get_state_pool());
+
+    // Each state holds a state block and two per agent buffers, one free block per size is kept
+    const auto state_pool = std::make_shared<BlockPool>(1);
+    const auto state = constructed_state.clone(state_pool);
+    EXPECT_EQ(state->get_state_pool(), state_pool);
+    std::vector<Reward> rewards;
+    Cost cost;
+    const JointAction jointaction(state->get_num_agents(), 1);
+
+    const CrossingState<Domain>* discarded_state = state->execute(jointaction, rewards, cost).get();
+    EXPECT_EQ(state_pool->num_free_blocks(), 2);
+
+    // Successors and clones reuse the memory of the discarded state
+    const auto next_state = state->execute(jointaction, rewards, cost);
+    EXPECT_EQ(next_state.get(), discarded_state);
+    EXPECT_EQ(next_state->get_state_pool(), state_pool);
+    EXPECT_EQ(state_pool->num_free_blocks(), 0);
+    {
+      const auto cloned_state = next_state->clone();
+      const auto second_cloned_state = next_state->clone();
+      EXPECT_EQ(cloned_state->get_state_pool(), state_pool);
+    }
+    EXPECT_EQ(state_pool->num_free_blocks(), 2);
+    EXPECT_TRUE(next_state->equals(*constructed_state.execute(jointaction, rewards, cost)));
+}
+
+TEST(hypothesis_crossing_state, hypothesis_context_scope_per_thread)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    const HypothesisContext shared_context(std::unordered_map<AgentIdx, HypothesisId>{{1, 0}, {2, 0}});
+    CrossingState<Domain> state(shared_context, params);
+    state.add_hypothesis(AgentPolicyCrossingState<Domain>({5,5}, params));
+    state.add_hypothesis(AgentPolicyCrossingState<Domain>({-2,-2}, params));
+
+    // Each thread resolves the hypotheses of its own scope on the same state
+    auto resolved_hypotheses = [&state](HypothesisId hypothesis) {
+      const HypothesisContext context(std::unordered_map<AgentIdx, HypothesisId>{{1, hypothesis}, {2, hypothesis}});
+      HypothesisContextScope scope(context);
+      std::vector<HypothesisId> resolved;
+      for (int i = 0; i < 1000; ++i) {
+        resolved.push_back(state.get_current_hypothesis(1 + i % 2));
+      }
+      return resolved;
+    };
+    auto first = std::async(std::launch::async, resolved_hypotheses, 0);
+    auto second = std::async(std::launch::async, resolved_hypotheses, 1);
+    EXPECT_EQ(first.get(), std::vector<HypothesisId>(1000, 0));
+    EXPECT_EQ(second.get(), std::vector<HypothesisId>(1000, 1));
+
+    {
+      const HypothesisContext context(std::unordered_map<AgentIdx, HypothesisId>{{1, 1}, {2, 1}});
+      HypothesisContextScope scope(context);
+      EXPECT_EQ(state.get_current_hypothesis(1), 1);
+    }
+    // Outside of any scope the shared context is used
+    EXPECT_EQ(state.get_current_hypothesis(1), 0);
+}
+
+TEST(crossing_state, mcts_pipelined_hypothesis_search)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 2000;
+    mcts_params.MAX_SEARCH_TIME = 100000;
+    mcts_params.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 4;
+    mcts_params.leaf_evaluation_pipeline.BATCH_SIZE = 4;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({5,5}, params));
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,-2}, params));
+    belief_tracker.belief_update(*state, *state);
+
+    // Iterations with different sampled hypotheses are in flight at the same time
+    Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+    mcts.search(*state, belief_tracker);
+    EXPECT_EQ(mcts.numIterations(), mcts_params.MAX_NUMBER_OF_ITERATIONS);
+    EXPECT_LT(mcts.returnBestAction(), state->get_num_actions(CrossingState<Domain>::ego_agent_idx));
+}
+
+// Zero values, records the sizes of the evaluated batches
+class BatchSizeRecordingHeuristic : public mcts::Heuristic<BatchSizeRecordingHeuristic>, public mcts::IgnoresHypothesisContext
+{
+public:
+    BatchSizeRecordingHeuristic(const MctsParameters& mcts_parameters) :
+            mcts::Heuristic<BatchSizeRecordingHeuristic>(mcts_parameters),
+            batch_sizes_(std::make_shared<std::vector<std::size_t>>()),
+            mutex_(std::make_shared<std::mutex>()) {}
+
+    template<class S, class SE, class SO, class H>
+    HeuristicValue calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
+        std::vector<HeuristicValue> heuristic_values;
+        calculate_heuristic_values_batch(std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>>{node}, heuristic_values);
+        return heuristic_values.front();
+    }
+
+    template<class S, class SE, class SO, class H>
+    void calculate_heuristic_values_batch(const std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>> &nodes,
+                                          std::vector<HeuristicValue>& heuristic_values) {
+        heuristic_values.assign(nodes.size(), HeuristicValue(nodes.front()->get_state()->get_num_agents()));
+        std::lock_guard<std::mutex> lock(*mutex_);
+        batch_sizes_->push_back(nodes.size());
+    }
+
+    std::string sprintf() const { return "BatchSizeRecordingHeuristic"; }
+
+    // Shared by all copies of the heuristic
+    std::shared_ptr<std::vector<std::size_t>> batch_sizes_;
+    std::shared_ptr<std::mutex> mutex_;
+};
+
+TEST(crossing_state, mcts_batched_hypothesis_search)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    for (const unsigned int num_evaluator_threads : {0u, 2u}) {
+      auto mcts_params = mcts_default_parameters();
+      mcts_params.MAX_NUMBER_OF_ITERATIONS = 500;
+      mcts_params.MAX_SEARCH_TIME = 100000;
+      mcts_params.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = num_evaluator_threads;
+      mcts_params.leaf_evaluation_pipeline.BATCH_SIZE = 4;
+      HypothesisBeliefTracker belief_tracker(mcts_params);
+      auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+      state->add_hypothesis(AgentPolicyCrossingState<Domain>({5,5}, params));
+      state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,-2}, params));
+      belief_tracker.belief_update(*state, *state);
+
+      // Leaves of iterations with different sampled hypotheses share a heuristic call
+      const BatchSizeRecordingHeuristic heuristic(mcts_params);
+      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, BatchSizeRecordingHeuristic> mcts(mcts_params, heuristic);
+      mcts.search(*state, belief_tracker);
+      EXPECT_EQ(mcts.numIterations(), mcts_params.MAX_NUMBER_OF_ITERATIONS);
+      const auto& batch_sizes = *heuristic.batch_sizes_;
+      ASSERT_FALSE(batch_sizes.empty());
+      EXPECT_EQ(*std::max_element(batch_sizes.begin(), batch_sizes.end()), mcts_params.leaf_evaluation_pipeline.BATCH_SIZE);
+    }
+}
+
+TEST(crossing_state, mcts_prune_hypotheses)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 1000;
+    mcts_params.MAX_SEARCH_TIME = 100000;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    mcts_params.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.05;
+    HypothesisBeliefTracker pruning_belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({5,5}, params));
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({-2,-2}, params));
+    belief_tracker.belief_update(*state, *state);
+    pruning_belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 4; ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      jointaction[CrossingState<Domain>::ego_agent_idx] = 1;
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                      state->get_ego_state(),
+                                                                      true_agents_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      pruning_belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    ASSERT_FALSE(pruning_belief_tracker.get_pruned_hypotheses().empty());
+
+    // Statistics of unlikely hypotheses are reclaimed from a tree searched without pruning
+    Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+    mcts.search(*state, belief_tracker);
+    const ActionIdx best_action = mcts.returnBestAction();
+    mcts.prune_hypotheses(pruning_belief_tracker);
+    EXPECT_EQ(mcts.returnBestAction(), best_action);
+}
+
 TEST(crossing_state, mcts_goal_reached_true_hypothesis)
-{   
+{
     const auto params = default_crossing_state_parameters<Domain>();
     auto mcts_params =mcts_default_parameters();
     mcts_params.hypothesis_belief_tracker.HISTORY_LENGTH = 4;
@@ -149,6 +713,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -165,7 +730,8 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(),
+                                                    true_agents_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -193,6 +759,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({-2,-2}, params);
+    std::mt19937 true_agents_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -207,7 +774,8 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(),
+                                                    true_agents_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -232,7 +800,30 @@ TEST(episode_runner, four_agents_reached_goal) {
   params.NUM_OTHER_AGENTS = 4;
   params.CHAIN_LENGTH = 41;
   params.EGO_GOAL_POS = 26;
-  auto runner = CrossingStateEpisodeRunner<Domain>(
+  CrossingStateEpisodeRunner<Domain> runner(
+      { {1 , AgentPolicyCrossingState<Domain>({5,5}, params)},
+        {2 , AgentPolicyCrossingState<Domain>({4,4}, params)},
+        {3 , AgentPolicyCrossingState<Domain>({6,6}, params)},
+        {4 , AgentPolicyCrossingState<Domain>({-2,-2}, params)}},
+      {AgentPolicyCrossingState<Domain>({4,5}, params), 
+        AgentPolicyCrossingState<Domain>({-2,3}, params),
+        AgentPolicyCrossingState<Domain>({5,6}, params)},
+        mcts_default_parameters(),
+        params,
+        30,
+        200,
+        10000,
+        nullptr);
+  auto result = runner.run();
+  EXPECT_TRUE(std::get<4>(result).second);
+}
+
+TEST(episode_runner, four_fixed_agents_reached_goal) {
+  auto params = default_crossing_state_parameters<Domain>();
+  params.NUM_OTHER_AGENTS = 4;
+  params.CHAIN_LENGTH = 41;
+  params.EGO_GOAL_POS = 26;
+  CrossingStateEpisodeRunner<Domain, RandomHeuristic, 4> runner(
       { {1 , AgentPolicyCrossingState<Domain>({5,5}, params)},
         {2 , AgentPolicyCrossingState<Domain>({4,4}, params)},
         {3 , AgentPolicyCrossingState<Domain>({6,6}, params)},
@@ -254,7 +845,7 @@ TEST(episode_runner, run_some_steps) {
   auto params = default_crossing_state_parameters<Domain>();
   params.CHAIN_LENGTH = 3;
   params.EGO_GOAL_POS = 1;
-  auto runner = CrossingStateEpisodeRunner<Domain>(
+  CrossingStateEpisodeRunner<Domain> runner(
       { {1 , AgentPolicyCrossingState<Domain>({5,5}, params)},
         {2 , AgentPolicyCrossingState<Domain>({5,5}, params)}},
       {AgentPolicyCrossingState<Domain>({4,5}, params), 
@@ -270,6 +861,27 @@ TEST(episode_runner, run_some_steps) {
   }
 }
 
+TEST(episode_runner, reuse_tree_reached_goal) {
+  auto params = default_crossing_state_parameters<Domain>();
+  auto mcts_params = mcts_default_parameters();
+  mcts_params.REUSE_TREE_ITERATIONS = 2000;
+  mcts_params.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.01;
+  CrossingStateEpisodeRunner<Domain> runner(
+      { {1 , AgentPolicyCrossingState<Domain>({5,5}, params)},
+        {2 , AgentPolicyCrossingState<Domain>({4,4}, params)}},
+      {AgentPolicyCrossingState<Domain>({4,5}, params), 
+        AgentPolicyCrossingState<Domain>({-2,3}, params),
+        AgentPolicyCrossingState<Domain>({5,6}, params)},
+        mcts_params,
+        params,
+        30,
+        200,
+        10000,
+        nullptr);
+  auto result = runner.run();
+  EXPECT_TRUE(std::get<4>(result).second);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
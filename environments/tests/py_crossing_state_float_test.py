@@ -8,7 +8,7 @@ import unittest
 from mamcts import CrossingStateFloat, CrossingStateEpisodeRunnerFloat
 from mamcts import AgentPolicyCrossingStateFloat, CrossingStateParametersFloat
 from mamcts import CrossingStateParametersFloat
-from mamcts import HypothesisBeliefTracker
+from mamcts import HypothesisBeliefTracker, HypothesisContext
 from environments.pyviewer import PyViewer
 from mamcts import MctsParameters, CrossingStateDefaultParametersFloat
 
@@ -18,9 +18,16 @@ def default_mcts_parameters():
     parameters.RANDOM_SEED = 1000
     parameters.MAX_SEARCH_TIME = 1000
     parameters.MAX_NUMBER_OF_ITERATIONS = 10000
+    parameters.REUSE_TREE_ITERATIONS = 0
+    parameters.TRANSPOSITION_TABLE = False
 
     parameters.random_heuristic.MAX_SEARCH_TIME = 10
     parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000
+    parameters.random_heuristic.ROLLOUT_HORIZON = 0
+    parameters.random_heuristic.COMMON_RANDOM_NUMBERS = False
+    parameters.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 1
+    parameters.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.0
+    parameters.random_heuristic.MAX_LEAF_EVALUATION_TIME = 100
 
     parameters.uct_statistic.LOWER_BOUND = -1000
     parameters.uct_statistic.UPPER_BOUND = 100
@@ -38,6 +45,12 @@ def default_mcts_parameters():
     parameters.hypothesis_belief_tracker.HISTORY_LENGTH = 4
     parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 1.0
     parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker.PosteriorType.PRODUCT
+    parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = False
+    parameters.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS = 0
+    parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.0
+
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 0
+    parameters.leaf_evaluation_pipeline.BATCH_SIZE = 1
 
     return parameters
 
@@ -45,7 +58,7 @@ class PickleTests(unittest.TestCase):
     def test_draw_state(self):
         crossing_state_params = CrossingStateDefaultParametersFloat()
         viewer = PyViewer()
-        state = CrossingStateFloat({}, crossing_state_params)
+        state = CrossingStateFloat(HypothesisContext(), crossing_state_params)
         print(state)
         state.draw(viewer)
         viewer.show(block=True)
@@ -5,10 +5,12 @@
 # ========================================================
 
 import unittest
+import numpy as np
 from mamcts import CrossingStateInt, CrossingStateEpisodeRunnerInt
+from mamcts import CrossingStateEpisodeRunnerPyValueInt
 from mamcts import AgentPolicyCrossingStateInt, CrossingStateParametersInt
 from mamcts import CrossingStateParametersInt
-from mamcts import HypothesisBeliefTracker
+from mamcts import HypothesisBeliefTracker, HypothesisContext
 from environments.pyviewer import PyViewer
 from mamcts import MctsParameters, CrossingStateDefaultParametersInt
 
@@ -18,9 +20,16 @@ def default_mcts_parameters():
     parameters.RANDOM_SEED = 1000
     parameters.MAX_SEARCH_TIME = 1000
     parameters.MAX_NUMBER_OF_ITERATIONS = 10000
+    parameters.REUSE_TREE_ITERATIONS = 0
+    parameters.TRANSPOSITION_TABLE = False
     
     parameters.random_heuristic.MAX_SEARCH_TIME = 10
     parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000
+    parameters.random_heuristic.ROLLOUT_HORIZON = 0
+    parameters.random_heuristic.COMMON_RANDOM_NUMBERS = False
+    parameters.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 1
+    parameters.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.0
+    parameters.random_heuristic.MAX_LEAF_EVALUATION_TIME = 100
 
     parameters.uct_statistic.LOWER_BOUND = -1000
     parameters.uct_statistic.UPPER_BOUND = 100
@@ -38,13 +47,19 @@ def default_mcts_parameters():
     parameters.hypothesis_belief_tracker.HISTORY_LENGTH = 4
     parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 1.0
     parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker.PosteriorType.PRODUCT
+    parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = False
+    parameters.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS = 0
+    parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.0
+
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 0
+    parameters.leaf_evaluation_pipeline.BATCH_SIZE = 1
 
     return parameters
 class PickleTests(unittest.TestCase):
     def test_draw_state(self):
         crossing_state_params = CrossingStateDefaultParametersInt()
         viewer = PyViewer()
-        state = CrossingStateInt({}, crossing_state_params)
+        state = CrossingStateInt(HypothesisContext(), crossing_state_params)
         state.draw(viewer)
         viewer.show(block=True)
 
@@ -86,5 +101,72 @@ class PickleTests(unittest.TestCase):
         episode_result = runner.run(False)
         print(episode_result)
 
+    def test_episode_runner_py_value(self):
+        crossing_state_params = CrossingStateDefaultParametersInt()
+        CrossingStateParametersInt.CHAIN_LENGTH = 21
+        batch_shapes = []
+        def value_function(features):
+            batch_shapes.append(features.shape)
+            # ego return grows towards the goal, others indifferent, no ego cost
+            values = np.zeros((features.shape[0], features.shape[1]//2 + 1), dtype=np.float32)
+            values[:, 0] = features[:, 0] / crossing_state_params.EGO_GOAL_POS
+            return values
+
+        mcts_parameters = default_mcts_parameters()
+        mcts_parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 2
+        mcts_parameters.leaf_evaluation_pipeline.BATCH_SIZE = 8
+        runner = CrossingStateEpisodeRunnerPyValueInt(
+            {1 : AgentPolicyCrossingStateInt((5,5), crossing_state_params),
+             2 : AgentPolicyCrossingStateInt((5,5), crossing_state_params) },
+            [AgentPolicyCrossingStateInt((4,5), crossing_state_params), 
+             AgentPolicyCrossingStateInt((5,6), crossing_state_params)],
+             mcts_parameters,
+             crossing_state_params,
+             30,
+             200,
+             1000,
+             None,
+             value_function)
+
+        runner.step()
+        self.assertTrue(len(batch_shapes) > 0)
+        self.assertTrue(all(shape[1] == 6 for shape in batch_shapes))
+        # leaves of iterations with different sampled hypotheses share a call of the value function
+        self.assertTrue(any(shape[0] > 1 for shape in batch_shapes))
+        self.assertTrue(all(shape[0] <= mcts_parameters.leaf_evaluation_pipeline.BATCH_SIZE for shape in batch_shapes))
+
+    def test_episode_runner_py_value_errors(self):
+        crossing_state_params = CrossingStateDefaultParametersInt()
+        CrossingStateParametersInt.CHAIN_LENGTH = 21
+        def wrong_shape_value_function(features):
+            return np.zeros((features.shape[0], 1), dtype=np.float32)
+
+        def raising_value_function(features):
+            raise ValueError("value function failed")
+
+        def make_runner(mcts_parameters, value_function):
+            return CrossingStateEpisodeRunnerPyValueInt(
+                {1 : AgentPolicyCrossingStateInt((5,5), crossing_state_params),
+                 2 : AgentPolicyCrossingStateInt((5,5), crossing_state_params) },
+                [AgentPolicyCrossingStateInt((4,5), crossing_state_params),
+                 AgentPolicyCrossingStateInt((5,6), crossing_state_params)],
+                 mcts_parameters,
+                 crossing_state_params,
+                 30,
+                 200,
+                 1000,
+                 None,
+                 value_function)
+
+        # errors on evaluator threads are raised by the step as well as errors in the search thread
+        for num_evaluator_threads in [0, 2]:
+            mcts_parameters = default_mcts_parameters()
+            mcts_parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = num_evaluator_threads
+            mcts_parameters.leaf_evaluation_pipeline.BATCH_SIZE = 8
+            with self.assertRaises(RuntimeError):
+                make_runner(mcts_parameters, wrong_shape_value_function).step()
+            with self.assertRaises(ValueError):
+                make_runner(mcts_parameters, raising_value_function).step()
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
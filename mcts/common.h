@@ -66,5 +66,17 @@ struct RequiresHypothesis
 struct RequiresCost 
 {};
 
+struct SupportsRandomSeeding // state draws the random numbers behind other agents' actions from the active RandomStreamScope
+{};
+
+struct SupportsHashing // state provides hash() and equals(), equal states have equal hashes
+{};
+
+struct IgnoresHypothesisContext // heuristic evaluates leaves without the sampled hypotheses, batches of a hypothesis-based search are evaluated at once
+{};
+
+struct SupportsStatePool // state provides clone(pool), the copy and all states derived from it are drawn from the pool
+{};
+
 } // namespace mcts
 #endif
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "state.h"
 #include "node_statistic.h"
 #include "mcts_parameters.h"
@@ -19,6 +20,17 @@ namespace mcts {
     template<class S, class SE, class SO, class H>
     class StageNode;
 
+    // Result of a heuristic leaf evaluation, only the values required to update the statistics
+    struct HeuristicValue
+    {
+        HeuristicValue() : returns(), ego_cost(0.0f), num_rollouts(0) {}
+        HeuristicValue(const AgentIdx& num_agents) : returns(num_agents, 0.0f), ego_cost(0.0f), num_rollouts(0) {}
+
+        std::vector<Reward> returns; // accumulated return of each agent, indexed as the joint action
+        Cost ego_cost; // accumulated ego cost
+        unsigned int num_rollouts; // rollouts used for the estimate
+    };
+
 
 
     template <class Implementation>
@@ -28,7 +40,17 @@ namespace mcts {
         Heuristic(const MctsParameters &mcts_parameters) : mcts_parameters_(mcts_parameters) {}
 
         template<class S, class SE, class SO, class H>
-        std::pair<SE, std::unordered_map<AgentIdx, SO>> calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node);
+        HeuristicValue calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node);
+
+        // Evaluates a batch of leaves, the default evaluates them one by one. Heuristics with
+        // a batched evaluator, e.g. a learned value function, hide it with their own implementation.
+        template<class S, class SE, class SO, class H>
+        void calculate_heuristic_values_batch(const std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>> &nodes,
+                                              std::vector<HeuristicValue>& heuristic_values);
+
+        // Reseeds a copy evaluating leaves on evaluator thread worker_idx, such that the copies do not
+        // repeat each other's random numbers. The default has no random numbers to reseed.
+        void seed(const unsigned int& worker_idx);
 
         std::string sprintf() const;
 
@@ -54,11 +76,26 @@ inline Implementation& Heuristic<Implementation>::impl() const {
 
 template <class Implementation>
 template<class S, class SE, class SO, class H>
-inline std::pair<SE, std::unordered_map<AgentIdx, SO>> Heuristic<Implementation>::calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node)
+inline HeuristicValue Heuristic<Implementation>::calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node)
 {
     return impl().calculate_heuristic_values(node);
 }
 
+template <class Implementation>
+template<class S, class SE, class SO, class H>
+inline void Heuristic<Implementation>::calculate_heuristic_values_batch(const std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>> &nodes,
+                                                                        std::vector<HeuristicValue>& heuristic_values)
+{
+    heuristic_values.clear();
+    heuristic_values.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        heuristic_values.push_back(impl().calculate_heuristic_values(node));
+    }
+}
+
+template <class Implementation>
+inline void Heuristic<Implementation>::seed(const unsigned int&) {}
+
 template <class Implementation>
 std::string Heuristic<Implementation>::sprintf() const
 {
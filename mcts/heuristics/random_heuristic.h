@@ -8,52 +8,140 @@
 #define RANDOM_HEURISTIC_H
 
 #include "mcts/mcts.h"
+#include "mcts/value_estimators/zero_value_estimator.h"
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <boost/functional/hash.hpp>
 
  namespace mcts {
 // assumes all agents have equal number of actions and the same node statistic
-class RandomHeuristic :  public mcts::Heuristic<RandomHeuristic>, mcts::RandomGenerator
+// Rollouts stop after random_heuristic.ROLLOUT_HORIZON steps (0 = no horizon), the return
+// of states not terminal at the end of a rollout is bootstrapped with the value estimator VE.
+// With random_heuristic.COMMON_RANDOM_NUMBERS, rollouts from siblings use the same random streams
+// for the other agents such that their returns differ mainly due to the joint action leading to them.
+// Each leaf is evaluated with the mean of up to random_heuristic.MAX_NUMBER_OF_ROLLOUTS rollouts.
+// Rollout states are drawn from a pool owned by each copy of the heuristic, such that evaluator threads
+// do not share the pool of the search.
+template<class VE>
+class TruncatedRandomHeuristic :  public mcts::Heuristic<TruncatedRandomHeuristic<VE>>, mcts::RandomGenerator
 {
 public:
-    RandomHeuristic(const MctsParameters& mcts_parameters) :
-            mcts::Heuristic<RandomHeuristic>(mcts_parameters),
-            RandomGenerator(mcts_parameters.RANDOM_SEED) {}
+    TruncatedRandomHeuristic(const MctsParameters& mcts_parameters) :
+            mcts::Heuristic<TruncatedRandomHeuristic<VE>>(mcts_parameters),
+            RandomGenerator(mcts_parameters.RANDOM_SEED),
+            rollout_random_stream_(mcts_parameters.RANDOM_SEED),
+            value_estimator_(mcts_parameters),
+            rollout_state_pool_(std::make_shared<BlockPool>()) {}
+
+    // Copies, e.g. those of the evaluator threads, get their own rollout state pool
+    TruncatedRandomHeuristic(const TruncatedRandomHeuristic& other) :
+            mcts::Heuristic<TruncatedRandomHeuristic<VE>>(other),
+            RandomGenerator(other),
+            rollout_random_stream_(other.rollout_random_stream_),
+            value_estimator_(other.value_estimator_),
+            rollout_state_pool_(std::make_shared<BlockPool>()) {}
+
+    // Copies on different evaluator threads draw different rollout seeds, common random numbers
+    // are derived from the tree and remain shared
+    void seed(const unsigned int& worker_idx) {
+        std::size_t seed = mcts_parameters_.RANDOM_SEED;
+        boost::hash_combine(seed, worker_idx);
+        random_generator_.seed(static_cast<unsigned int>(seed));
+        rollout_random_stream_.seed(random_generator_());
+    }
 
     template<class S, class SE, class SO, class H>
-    std::pair<SE, std::unordered_map<AgentIdx, SO>> calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
+    HeuristicValue calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
+        HeuristicValue heuristic_value(node->get_state()->get_num_agents());
         //catch case where newly expanded state is terminal
         if(node->get_state()->is_terminal()){
-            const auto ego_agent_idx = node->get_state()->get_ego_agent_idx();
-            const ActionIdx num_ego_actions = node->get_state()->get_num_actions(ego_agent_idx); 
-            SE ego_heuristic(num_ego_actions, node->get_state()->get_ego_agent_idx(), mcts_parameters_);
-            ego_heuristic.set_heuristic_estimate(0.0f, 0.0f);
-            std::unordered_map<AgentIdx, SO> other_heuristic_estimates;
-            for (const auto& ai : node->get_state()->get_other_agent_idx())
-            { 
-              SO statistic(node->get_state()->get_num_actions(ai), ai, mcts_parameters_);
-              statistic.set_heuristic_estimate(0.0f, 0.0f);
-              other_heuristic_estimates.insert(std::pair<AgentIdx, SO>(ai, statistic));
-            }
-            return std::pair<SE, std::unordered_map<AgentIdx, SO>>(ego_heuristic, other_heuristic_estimates) ;
+            return heuristic_value;
         }
-        
-        namespace chr = std::chrono;
+
+        // Repeat rollouts until the standard errors of ego return and ego cost fall below the threshold,
+        // the maximum number of rollouts is reached or the time slice of this leaf is spent
         auto start = std::chrono::high_resolution_clock::now();
-        std::shared_ptr<S> state = node->get_state()->clone();
+        const auto& parameters = mcts_parameters_.random_heuristic;
+        const unsigned int max_num_rollouts = std::max(parameters.MAX_NUMBER_OF_ROLLOUTS, 1u);
+        RunningStatistic ego_return_statistic;
+        RunningStatistic ego_cost_statistic;
+        while(heuristic_value.num_rollouts < max_num_rollouts) {
+            const HeuristicValue rollout_value = rollout(node, heuristic_value.num_rollouts);
+            heuristic_value.num_rollouts += 1;
+            const double weight = 1.0/heuristic_value.num_rollouts;
+            for (AgentIdx ai = 0; ai < heuristic_value.returns.size(); ++ai) {
+              heuristic_value.returns[ai] += weight*(rollout_value.returns[ai] - heuristic_value.returns[ai]);
+            }
+            heuristic_value.ego_cost += weight*(rollout_value.ego_cost - heuristic_value.ego_cost);
 
-        Reward ego_accum_reward = 0.0f;
-        std::unordered_map<AgentIdx, Reward> other_accum_rewards;
-        for (const auto& ai : state->get_other_agent_idx()) {
-          other_accum_rewards[ai] = 0.0f;
+            ego_return_statistic.add(rollout_value.returns[S::ego_agent_idx]);
+            ego_cost_statistic.add(rollout_value.ego_cost);
+            if(heuristic_value.num_rollouts > 1 &&
+                ego_return_statistic.standard_error() <= parameters.ROLLOUT_STANDARD_ERROR_THRESHOLD &&
+                ego_cost_statistic.standard_error() <= parameters.ROLLOUT_STANDARD_ERROR_THRESHOLD) {
+                break;
+            }
+            if(std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count()
+                    >= parameters.MAX_LEAF_EVALUATION_TIME) {
+                break;
+            }
         }
+        return heuristic_value;
+    }
+
+private:
+    using mcts::Heuristic<TruncatedRandomHeuristic<VE>>::mcts_parameters_;
+
+    // Welford's online mean and variance
+    class RunningStatistic {
+    public:
+        RunningStatistic() : count_(0), mean_(0.0), squared_deviations_(0.0) {}
+        void add(const double& value) {
+            count_ += 1;
+            const double delta = value - mean_;
+            mean_ += delta/count_;
+            squared_deviations_ += delta*(value - mean_);
+        }
+        double standard_error() const {
+            return count_ > 1 ? std::sqrt(squared_deviations_/(count_ - 1)/count_) : std::numeric_limits<double>::max();
+        }
+    private:
+        unsigned int count_;
+        double mean_;
+        double squared_deviations_;
+    };
+
+    template<class S, class SE, class SO, class H>
+    HeuristicValue rollout(const std::shared_ptr<StageNode<S,SE,SO,H>> &node, const unsigned int& rollout_idx) {
+        HeuristicValue heuristic_value(node->get_state()->get_num_agents());
+        heuristic_value.num_rollouts = 1;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<S> state = clone_rollout_state(*node->get_state());
+        seed_rollout(node, rollout_idx);
+        RandomStreamScope random_stream_scope(rollout_random_stream_);
 
-        Cost accum_cost = 0.0f;
         const double k_discount_factor = mcts_parameters_.DISCOUNT_FACTOR; 
         double modified_discount_factor = k_discount_factor;
-        int num_iterations = 0;
-        
-        while((!state->is_terminal())&&(num_iterations<mcts_parameters_.random_heuristic.MAX_NUMBER_OF_ITERATIONS)&&
+        unsigned int num_iterations = 0;
+        const unsigned int rollout_horizon = mcts_parameters_.random_heuristic.ROLLOUT_HORIZON;
+        const unsigned int max_rollout_steps = (rollout_horizon > 0) ?
+                    std::min(rollout_horizon, mcts_parameters_.random_heuristic.MAX_NUMBER_OF_ITERATIONS) :
+                    mcts_parameters_.random_heuristic.MAX_NUMBER_OF_ITERATIONS;
+
+        // accumulates the discounted values of one step, indexed as the joint action
+        auto accumulate = [&](const std::vector<Reward>& values, const Cost& ego_cost) {
+            for (AgentIdx ai = 0; ai < heuristic_value.returns.size(); ++ai) {
+              heuristic_value.returns[ai] += modified_discount_factor*values[ai];
+            }
+            heuristic_value.ego_cost += modified_discount_factor*ego_cost;
+        };
+
+        std::vector<Reward> step_rewards(state->get_num_agents());
+        while((!state->is_terminal())&&(num_iterations<max_rollout_steps)&&
                 (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() 
                     < mcts_parameters_.random_heuristic.MAX_SEARCH_TIME )) {
             // Build joint action by calling statistics for each agent
@@ -63,46 +151,68 @@ public:
                           mcts_parameters_);
             jointaction[S::ego_agent_idx] = ego_statistic.choose_next_action(*state);
             AgentIdx action_idx = 1;
-            for (const auto& ai : state->get_other_agent_idx()) {
+            for (const auto ai : state->get_other_agent_idx_range()) {
               SO statistic(state->get_num_actions(ai), ai, mcts_parameters_);
               jointaction[action_idx] = statistic.choose_next_action(*state);
               action_idx++;
             }
 
             Cost ego_cost;
-            std::vector<Reward> step_rewards(state->get_num_agents());
             auto new_state = state->execute(jointaction, step_rewards, ego_cost);
 
-            ego_accum_reward += modified_discount_factor*step_rewards[S::ego_agent_idx];
-            AgentIdx reward_idx = 1;
-            for (const auto& ai : state->get_other_agent_idx()) {
-              other_accum_rewards[ai] = modified_discount_factor*step_rewards[reward_idx];
-              action_idx++;
-            }
-
-            accum_cost += modified_discount_factor*ego_cost;
+            accumulate(step_rewards, ego_cost);
             modified_discount_factor = modified_discount_factor*k_discount_factor;
 
             state = new_state->clone();
             num_iterations +=1;
          };
-        // generate an extra node statistic for each agent
-        SE ego_heuristic(0, node->get_state()->get_ego_agent_idx(), mcts_parameters_);
-        ego_heuristic.set_heuristic_estimate(ego_accum_reward, accum_cost);
-        std::unordered_map<AgentIdx, SO> other_heuristic_estimates;
-        AgentIdx reward_idx=1;
-        for (auto agent_idx : node->get_state()->get_other_agent_idx())
-        {
-            SO statistic(0, agent_idx, mcts_parameters_);
-            statistic.set_heuristic_estimate(other_accum_rewards[agent_idx], accum_cost);
-            other_heuristic_estimates.insert(std::pair<AgentIdx, SO>(agent_idx, statistic));
-            reward_idx++;
+
+        // Bootstrap the remaining return of a truncated rollout
+        if(!state->is_terminal()) {
+            Cost tail_ego_cost;
+            std::vector<Reward> tail_values;
+            value_estimator_.estimate_value(*state, tail_values, tail_ego_cost);
+            accumulate(tail_values, tail_ego_cost);
+        }
+        return heuristic_value;
+    }
+
+    // With common random numbers, siblings share the seeds derived from their parent node for each
+    // rollout index. Otherwise, repeated rollouts of a leaf draw independent seeds.
+    template<class S, class SE, class SO, class H>
+    typename std::enable_if<std::is_base_of<SupportsRandomSeeding, S>::value>::type
+    seed_rollout(const std::shared_ptr<StageNode<S,SE,SO,H>> &node, const unsigned int& rollout_idx) {
+        if(mcts_parameters_.random_heuristic.COMMON_RANDOM_NUMBERS) {
+            const auto parent = node->get_parent().lock();
+            std::size_t seed = mcts_parameters_.RANDOM_SEED;
+            boost::hash_combine(seed, parent ? parent->get_id() : node->get_id());
+            boost::hash_combine(seed, rollout_idx);
+            rollout_random_stream_.seed(static_cast<unsigned int>(seed));
+        } else if(rollout_idx > 0) {
+            rollout_random_stream_.seed(random_generator_());
         }
-        return std::pair<SE, std::unordered_map<AgentIdx, SO>>(ego_heuristic, other_heuristic_estimates);
     }
 
+    template<class S, class SE, class SO, class H>
+    typename std::enable_if<!std::is_base_of<SupportsRandomSeeding, S>::value>::type
+    seed_rollout(const std::shared_ptr<StageNode<S,SE,SO,H>>&, const unsigned int&) {}
+
+    // All states of a rollout are derived from the first clone and share its pool
+    template<class S>
+    typename std::enable_if<std::is_base_of<SupportsStatePool, S>::value, std::shared_ptr<S>>::type
+    clone_rollout_state(const S& state) const { return state.clone(rollout_state_pool_); }
+
+    template<class S>
+    typename std::enable_if<!std::is_base_of<SupportsStatePool, S>::value, std::shared_ptr<S>>::type
+    clone_rollout_state(const S& state) const { return state.clone(); }
+
+    RandomStream rollout_random_stream_; // active during rollouts, each heuristic copy owns its stream
+    VE value_estimator_;
+    std::shared_ptr<BlockPool> rollout_state_pool_; // only used by the thread evaluating with this copy
 };
 
+using RandomHeuristic = TruncatedRandomHeuristic<ZeroValueEstimator>;
+
  } // namespace mcts
 
 #endif
\ No newline at end of file
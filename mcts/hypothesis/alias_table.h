@@ -0,0 +1,106 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_HYPOTHESIS_ALIAS_TABLE_H
+#define MCTS_HYPOTHESIS_ALIAS_TABLE_H
+
+#include <random>
+#include <vector>
+
+namespace mcts {
+
+/*
+ * Walker's alias table (Vose's construction) for sampling an index from a fixed discrete
+ * distribution in O(1). Building the table takes O(n), weights need not be normalized.
+ * Without any positive weight the last index is always sampled, as the former std::discrete_distribution
+ * did for agents whose hypotheses all have zero belief.
+ */
+class AliasTable {
+  public:
+    AliasTable() : probabilities_(), aliases_() {}
+
+    template<typename Weight>
+    AliasTable(const std::vector<Weight>& weights) : probabilities_(), aliases_() {
+      build(weights);
+    }
+
+    template<typename Weight>
+    void build(const std::vector<Weight>& weights);
+
+    template<typename Index, typename Generator>
+    Index sample(Generator& random_generator) const;
+
+    std::size_t size() const { return probabilities_.size(); }
+
+  private:
+    std::vector<double> probabilities_; // probability to keep a column instead of taking its alias
+    std::vector<std::size_t> aliases_;
+};
+
+template<typename Weight>
+inline void AliasTable::build(const std::vector<Weight>& weights) {
+  const std::size_t num_columns = weights.size();
+  probabilities_.assign(num_columns, 1.0);
+  aliases_.resize(num_columns);
+  for (std::size_t idx = 0; idx < num_columns; ++idx) {
+    aliases_[idx] = idx;
+  }
+
+  double weight_sum = 0.0;
+  for (const auto& weight : weights) {
+    weight_sum += weight > 0 ? static_cast<double>(weight) : 0.0;
+  }
+  if (weight_sum <= 0.0) {
+    for (std::size_t idx = 0; idx < num_columns; ++idx) {
+      probabilities_[idx] = 0.0;
+      aliases_[idx] = num_columns - 1;
+    }
+    return;
+  }
+
+  // Scale to an average column height of one and pair underfull with overfull columns
+  std::vector<double> scaled(num_columns);
+  std::vector<std::size_t> small, large;
+  for (std::size_t idx = 0; idx < num_columns; ++idx) {
+    scaled[idx] = (weights[idx] > 0 ? static_cast<double>(weights[idx]) : 0.0) * num_columns / weight_sum;
+    if (scaled[idx] < 1.0) {
+      small.push_back(idx);
+    } else {
+      large.push_back(idx);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    const std::size_t small_idx = small.back();
+    small.pop_back();
+    const std::size_t large_idx = large.back();
+    probabilities_[small_idx] = scaled[small_idx];
+    aliases_[small_idx] = large_idx;
+    scaled[large_idx] -= 1.0 - scaled[small_idx];
+    if (scaled[large_idx] < 1.0) {
+      large.pop_back();
+      small.push_back(large_idx);
+    }
+  }
+  // Remaining columns are full up to rounding errors
+  for (const auto idx : small) {
+    probabilities_[idx] = 1.0;
+  }
+  for (const auto idx : large) {
+    probabilities_[idx] = 1.0;
+  }
+}
+
+template<typename Index, typename Generator>
+inline Index AliasTable::sample(Generator& random_generator) const {
+  std::uniform_int_distribution<std::size_t> column_distribution(0, probabilities_.size() - 1);
+  std::uniform_real_distribution<double> keep_distribution(0.0, 1.0);
+  const std::size_t column = column_distribution(random_generator);
+  return static_cast<Index>(keep_distribution(random_generator) < probabilities_[column] ? column : aliases_[column]);
+}
+
+} // namespace mcts
+
+#endif // MCTS_HYPOTHESIS_ALIAS_TABLE_H
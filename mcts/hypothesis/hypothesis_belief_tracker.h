@@ -7,12 +7,18 @@
 #ifndef MCTS_HYPOTHESIS_HYPOTHESISBELIEFTRACKER_H
 #define MCTS_HYPOTHESIS_HYPOTHESISBELIEFTRACKER_H
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <random>
-#include <deque>
+#include <vector>
 
 #include "mcts/mcts_parameters.h"
 #include "mcts/hypothesis/common.h"
+#include "mcts/hypothesis/alias_table.h"
 #include "mcts/random_generator.h"
+#include "mcts/thread_pool.h"
 #include "mcts/hypothesis/hypothesis_state.h"
 
 
@@ -32,34 +38,104 @@ class HypothesisBeliefTracker : public mcts::RandomGenerator {
                             history_length_(mcts_parameters.hypothesis_belief_tracker.HISTORY_LENGTH),
                             probability_discount_(mcts_parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT),
                             posterior_type_(static_cast<PosteriorType>(mcts_parameters.hypothesis_belief_tracker.POSTERIOR_TYPE)),
-                            fixed_hypothesis_set_(static_cast<std::unordered_map<AgentIdx, HypothesisId>>(
-                              mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET)),
                             tracked_probabilities_(),
+                            action_probabilities_(),
                             tracked_beliefs_(),
-                            current_sampled_hypothesis_() {};
+                            hypothesis_samplers_(),
+                            current_sampled_hypothesis_(),
+                            fixed_hypothesis_set_(static_cast<std::unordered_map<AgentIdx, HypothesisId>>(
+                              mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET)),
+                            stratified_hypothesis_schedule_(mcts_parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE),
+                            belief_pruning_threshold_(mcts_parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD),
+                            hypothesis_schedule_(),
+                            scheduled_iterations_(0),
+                            belief_update_pool_(mcts_parameters.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS > 0 ?
+                              std::make_shared<ThreadPool>(mcts_parameters.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS) : nullptr) {};
 
     template <typename S>
     void belief_update(const HypothesisStateInterface<S>& state,
                       const HypothesisStateInterface<S>& next_state);
 
-    const std::unordered_map<AgentIdx, HypothesisId>& sample_current_hypothesis(); // shared across all states
+    const HypothesisContext& sample_current_hypothesis(); // shared across all states
 
-    const std::unordered_map<AgentIdx, std::vector<Belief>> get_beliefs() const {
-      return tracked_beliefs_;
-    }
+    // Pre-samples the hypotheses of the next search if a stratified schedule is enabled
+    void schedule_hypotheses(const unsigned int& num_iterations);
+
+    // Takes the scheduled hypotheses of a search iteration, samples them if not covered by the schedule
+    const HypothesisContext& sample_current_hypothesis(const unsigned int& iteration);
+
+    const std::unordered_map<AgentIdx, std::vector<Belief>> get_beliefs() const;
+
+    // Hypotheses currently excluded from sampling as their belief is below the pruning threshold
+    const std::unordered_map<AgentIdx, std::vector<HypothesisId>> get_pruned_hypotheses() const;
 
     std::string sprintf() const;
 
     void update_fixed_hypothesis_set(const std::unordered_map<AgentIdx, HypothesisId>& hypothesis_set);
 
 private:
+    template <typename S>
+    void agent_belief_update(const HypothesisStateInterface<S>& state,
+                            const HypothesisStateInterface<S>& next_state,
+                            const AgentIdx& agent_idx, const std::size_t& slot);
+
+    // Beliefs below the bound are not sampled, the most likely hypothesis of an agent is never pruned
+    Belief belief_pruning_bound(const std::vector<Belief>& beliefs) const;
+
+    /*
+     * Window of the last HISTORY_LENGTH action probabilities of a hypothesis stored in a ring buffer.
+     * The terms of both posterior types are maintained incrementally such that an update does not
+     * depend on the history length. Products are kept in log-space to avoid underflow, zero probabilities
+     * are counted separately as their logarithm is undefined.
+     */
+    class ProbabilityHistory {
+      public:
+        ProbabilityHistory(const unsigned int& history_length, const float& probability_discount) :
+                  probabilities_(history_length, 0.0),
+                  next_(0),
+                  size_(0),
+                  log_product_(0.0),
+                  num_zeros_(0),
+                  discounted_sum_(0.0),
+                  probability_discount_(probability_discount),
+                  evicted_discount_(std::pow(static_cast<double>(probability_discount), history_length + 1)) {}
+
+        void push(const Probability& probability);
+
+        // Discounted product, newest probability discounted once, oldest size() times; -inf if zero
+        double log_discounted_product() const;
+
+        // Discounted sum, newest probability discounted once, oldest size() times
+        double discounted_sum() const { return std::max(discounted_sum_, 0.0); } // eviction may leave rounding residues
+
+        std::size_t size() const { return size_; }
+
+      private:
+        std::vector<Probability> probabilities_;
+        std::size_t next_; // slot of the next probability, holds the oldest one if the window is full
+        std::size_t size_;
+        double log_product_; // sum of the logarithms of all nonzero probabilities, without discount
+        unsigned int num_zeros_;
+        double discounted_sum_;
+        double probability_discount_;
+        double evicted_discount_; // discount of a probability when leaving the window
+    };
+
     unsigned int history_length_;
     float probability_discount_;
     PosteriorType posterior_type_;
-    std::unordered_map<AgentIdx, std::vector<std::deque<Probability>>> tracked_probabilities_;
-    std::unordered_map<AgentIdx, std::vector<Belief>> tracked_beliefs_;//< contains the beliefs for each hypothesis for each agent 
-    std::unordered_map<AgentIdx, HypothesisId> current_sampled_hypothesis_; //< the currently sampled hypothesis shared across all hypothesis states
+    // Per agent data is indexed by the agent's slot in the hypothesis context
+    std::vector<std::vector<ProbabilityHistory>> tracked_probabilities_;
+    std::vector<std::vector<Probability>> action_probabilities_; //< last action probabilities of all hypotheses, reused across updates
+    std::vector<std::vector<Belief>> tracked_beliefs_;//< contains the beliefs for each hypothesis for each agent, empty if not tracked
+    std::vector<AliasTable> hypothesis_samplers_; //< rebuilt from the beliefs after each belief update
+    HypothesisContext current_sampled_hypothesis_; //< the currently sampled hypothesis shared across all hypothesis states
     std::unordered_map<AgentIdx, HypothesisId> fixed_hypothesis_set_; // < if not empty a fixed hypothesis set is used in each iteration (e.g. for the omniscient approach)
+    bool stratified_hypothesis_schedule_;
+    double belief_pruning_threshold_;
+    std::vector<std::vector<HypothesisId>> hypothesis_schedule_; //< hypothesis of each agent slot for each iteration of a search
+    unsigned int scheduled_iterations_;
+    std::shared_ptr<ThreadPool> belief_update_pool_; //< only set if agents are updated in parallel
 };
 
 
@@ -71,81 +147,262 @@ void HypothesisBeliefTracker::belief_update(const HypothesisStateInterface<S>& s
     return;
   }
 
-  for(auto agent_idx : next_state.get_other_agent_idx() ) {
-    auto belief_track_it = tracked_beliefs_.find(agent_idx);
-    if(belief_track_it == tracked_beliefs_.end()) {
+  // Slots and tracking are set up serially, the update of an agent then only touches its own slot
+  const auto other_agent_idx = next_state.get_other_agent_idx_range();
+  std::vector<std::size_t> slots;
+  slots.reserve(other_agent_idx.size());
+  for(auto agent_idx : other_agent_idx) {
+    const std::size_t slot = current_sampled_hypothesis_.slot(agent_idx);
+    if(slot >= tracked_beliefs_.size()) {
+      tracked_beliefs_.resize(slot + 1);
+      tracked_probabilities_.resize(slot + 1);
+      action_probabilities_.resize(slot + 1);
+      hypothesis_samplers_.resize(slot + 1);
+    }
+    if(tracked_beliefs_[slot].empty()) {
       // Init belief and probability tracking
-      auto& belief_track_agent = tracked_beliefs_[agent_idx];
-      auto& probability_track_agent = tracked_probabilities_[agent_idx];
+      auto& belief_track_agent = tracked_beliefs_[slot];
+      auto& probability_track_agent = tracked_probabilities_[slot];
       const auto num_hypothesis = state.get_num_hypothesis(agent_idx);
       for (HypothesisId hid = 0; hid < num_hypothesis; ++hid) {
         belief_track_agent.push_back(0.0f); // use as default but overwritten later
-        probability_track_agent.push_back(std::deque<Probability>());
+        probability_track_agent.emplace_back(history_length_, probability_discount_);
       }
     }
+    slots.push_back(slot);
+  }
 
+  // Agents are independent, results do not depend on the number of threads
+  auto update_agent = [&](const std::size_t& idx) {
+    agent_belief_update(state, next_state, other_agent_idx[idx], slots[idx]);
+  };
+  if(belief_update_pool_ && other_agent_idx.size() > 1) {
+    belief_update_pool_->parallel_for(other_agent_idx.size(), update_agent);
+  } else {
+    for (std::size_t idx = 0; idx < other_agent_idx.size(); ++idx) {
+      update_agent(idx);
+    }
+  }
+}
+
+template <typename S>
+void HypothesisBeliefTracker::agent_belief_update(const HypothesisStateInterface<S>& state,
+                                                  const HypothesisStateInterface<S>& next_state,
+                                                  const AgentIdx& agent_idx, const std::size_t& slot) {
     // Update belief for each tracked hypothesis
-    auto& belief_track_agent = tracked_beliefs_[agent_idx];
-    auto& probability_track_agent = tracked_probabilities_[agent_idx];
-    float belief_sum = 0.0f;
-    for (HypothesisId hid = 0; hid < belief_track_agent.size(); ++hid) {
-        // add latest hypothesis probability if states are different
-        // otherwise this step is skipped initializing only with prior
-        if (std::addressof(state) != std::addressof(next_state)) {
-          const auto& last_action = next_state.template get_last_action<typename S::ActionType>(agent_idx);
-          probability_track_agent[hid].push_back(state.template get_probability<typename S::ActionType>(hid, agent_idx, last_action));
-          if (probability_track_agent[hid].size()>history_length_) {
-            probability_track_agent[hid].pop_front();
-          }
-        }
+    auto& belief_track_agent = tracked_beliefs_[slot];
+    auto& probability_track_agent = tracked_probabilities_[slot];
+    // add latest hypothesis probability if states are different
+    // otherwise this step is skipped initializing only with prior
+    if (std::addressof(state) != std::addressof(next_state)) {
+      // All hypotheses are evaluated with a single call
+      const auto& last_action = next_state.template get_last_action<typename S::ActionType>(agent_idx);
+      auto& action_probabilities = action_probabilities_[slot];
+      state.impl().template get_probabilities<typename S::ActionType>(agent_idx, last_action, action_probabilities);
+      MCTS_EXPECT_TRUE(action_probabilities.size() >= belief_track_agent.size());
+      for (HypothesisId hid = 0; hid < belief_track_agent.size(); ++hid) {
+        probability_track_agent[hid].push(action_probabilities[hid]);
+      }
+    }
 
-        // calculate belief
-        Probability belief;
-        if(posterior_type_ == PosteriorType::PRODUCT) {
-            belief = state.get_prior(hid, agent_idx);
-          } else if(posterior_type_ == PosteriorType::SUM) {
-            belief = 0.0001f; // some small value to initialize sum
-          }
-        float current_pdiscount = probability_discount_;
-        const auto& probabilities = probability_track_agent[hid];
-        //std::cout << "Update ------------------" << std::endl;
-        for(auto pit = probabilities.rbegin(); pit != probabilities.rend(); ++pit) {
-          //std::cout << "Probabilities: hyp = " << hid << "agent =" << int(agent_idx) << ", P=" << *pit<< std::endl;
-          if(posterior_type_ == PosteriorType::PRODUCT) {
-            belief *= *pit*current_pdiscount;
-          } else if(posterior_type_ == PosteriorType::SUM) {
-            belief += *pit*current_pdiscount;
-          }
-          current_pdiscount = current_pdiscount*probability_discount_;
-        }
-        belief_track_agent[hid] = belief;
-        belief_sum += belief_track_agent[hid];
+    // calculate belief, products stay in log-space until normalization
+    if(posterior_type_ == PosteriorType::PRODUCT) {
+      for (HypothesisId hid = 0; hid < belief_track_agent.size(); ++hid) {
+        const Probability prior = state.get_prior(hid, agent_idx);
+        belief_track_agent[hid] = prior > 0.0 ? std::log(prior) + probability_track_agent[hid].log_discounted_product()
+                                              : -std::numeric_limits<Belief>::infinity();
+      }
+    } else if(posterior_type_ == PosteriorType::SUM) {
+      for (HypothesisId hid = 0; hid < belief_track_agent.size(); ++hid) {
+        belief_track_agent[hid] = 0.0001 + probability_track_agent[hid].discounted_sum(); // some small value to initialize sum
+      }
     }
 
     // Normalize beliefs
-    if(belief_sum > 0.0f) {
+    if(posterior_type_ == PosteriorType::PRODUCT) {
+      // log-sum-exp, all beliefs remain zero if each hypothesis has zero probability
+      Belief max_log_belief = -std::numeric_limits<Belief>::infinity();
+      for (const auto& log_belief : belief_track_agent) {
+        max_log_belief = std::max(max_log_belief, log_belief);
+      }
+      for (auto& belief : belief_track_agent) {
+        belief = std::isfinite(max_log_belief) ? std::exp(belief - max_log_belief) : 0.0;
+      }
+    }
+    Belief belief_sum = 0.0;
+    for (const auto& belief : belief_track_agent) {
+      belief_sum += belief;
+    }
+    if(belief_sum > 0.0) {
       for (HypothesisId hid = 0; hid < belief_track_agent.size(); ++hid) {
           belief_track_agent[hid] /= belief_sum;
       }
+    }
+    // Beliefs only change here, sampling in each search iteration then takes constant time
+    const Belief pruning_bound = belief_pruning_bound(belief_track_agent);
+    if (pruning_bound > 0.0) {
+      std::vector<Belief> sampling_weights(belief_track_agent);
+      for (auto& weight : sampling_weights) {
+        weight = weight < pruning_bound ? 0.0 : weight;
+      }
+      hypothesis_samplers_[slot].build(sampling_weights);
+    } else {
+      hypothesis_samplers_[slot].build(belief_track_agent);
+    }
+}
+
+inline void HypothesisBeliefTracker::ProbabilityHistory::push(const Probability& probability) {
+  // All probabilities in the window gain another discount factor
+  discounted_sum_ *= probability_discount_;
+  if (probabilities_.empty()) {
+    return;
+  }
+  if (size_ == probabilities_.size()) {
+    // Evict the oldest probability
+    const Probability evicted = probabilities_[next_];
+    if (evicted > 0.0) {
+      log_product_ -= std::log(evicted);
+    } else {
+      num_zeros_ -= 1;
+    }
+    discounted_sum_ -= evicted*evicted_discount_;
+  } else {
+    size_ += 1;
   }
+  probabilities_[next_] = probability;
+  next_ = (next_ + 1) % probabilities_.size();
+  if (probability > 0.0) {
+    log_product_ += std::log(probability);
+  } else {
+    num_zeros_ += 1;
   }
+  discounted_sum_ += probability*probability_discount_;
 }
 
-inline const std::unordered_map<AgentIdx, HypothesisId>& HypothesisBeliefTracker::sample_current_hypothesis() {
+inline double HypothesisBeliefTracker::ProbabilityHistory::log_discounted_product() const {
+  if (size_ == 0) {
+    return 0.0;
+  }
+  if (num_zeros_ > 0 || probability_discount_ <= 0.0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  // Discount factors of the window: d^1 * d^2 * ... * d^size
+  return log_product_ + 0.5*size_*(size_ + 1)*std::log(probability_discount_);
+}
+
+inline const HypothesisContext& HypothesisBeliefTracker::sample_current_hypothesis() {
   if(!fixed_hypothesis_set_.empty()) {
-    current_sampled_hypothesis_ = fixed_hypothesis_set_;
+    for (const auto& it : fixed_hypothesis_set_) {
+      current_sampled_hypothesis_[it.first] = it.second;
+    }
     return current_sampled_hypothesis_;
   }
 
-  for (const auto& it : tracked_beliefs_) {
-    // Sample one hypothesis for each agent
-    std::discrete_distribution<HypothesisId> hypothesis_distribution(it.second.begin(), it.second.end());
-    auto& hypothesis_id = current_sampled_hypothesis_[it.first];
-    hypothesis_id = hypothesis_distribution(random_generator_);
+  for (std::size_t slot = 0; slot < hypothesis_samplers_.size(); ++slot) {
+    // Sample one hypothesis for each tracked agent
+    if (hypothesis_samplers_[slot].size() > 0) {
+      current_sampled_hypothesis_.set_hypothesis(slot, hypothesis_samplers_[slot].sample<HypothesisId>(random_generator_));
+    }
   }
   return current_sampled_hypothesis_;
 }
 
+inline void HypothesisBeliefTracker::schedule_hypotheses(const unsigned int& num_iterations) {
+  hypothesis_schedule_.clear();
+  scheduled_iterations_ = 0;
+  if(!stratified_hypothesis_schedule_ || !fixed_hypothesis_set_.empty() || num_iterations == 0) {
+    return;
+  }
+  scheduled_iterations_ = num_iterations;
+
+  std::uniform_real_distribution<double> offset_distribution(0.0, 1.0);
+  hypothesis_schedule_.resize(tracked_beliefs_.size());
+  for (std::size_t slot = 0; slot < tracked_beliefs_.size(); ++slot) {
+    const auto& beliefs = tracked_beliefs_[slot];
+    auto& schedule = hypothesis_schedule_[slot];
+    if (beliefs.empty()) {
+      continue;
+    }
+    const Belief pruning_bound = belief_pruning_bound(beliefs);
+    auto sampling_weight = [&beliefs, &pruning_bound](const HypothesisId& hid) {
+      return beliefs[hid] < pruning_bound ? 0.0 : std::max(beliefs[hid], 0.0);
+    };
+    Belief belief_sum = 0.0;
+    for (HypothesisId hid = 0; hid < beliefs.size(); ++hid) {
+      belief_sum += sampling_weight(hid);
+    }
+
+    // Systematic sampling: one point per stratum [k/N, (k+1)/N) with a common random offset,
+    // each hypothesis is then scheduled within one iteration of its expected count
+    schedule.reserve(num_iterations);
+    if (belief_sum <= 0.0) {
+      schedule.assign(num_iterations, beliefs.size() - 1); // same as sampling without positive belief
+    } else {
+      const double offset = offset_distribution(random_generator_);
+      HypothesisId hid = 0;
+      double cumulative_belief = sampling_weight(0)/belief_sum;
+      for (unsigned int iteration = 0; iteration < num_iterations; ++iteration) {
+        const double point = (iteration + offset)/num_iterations;
+        while (point >= cumulative_belief && hid + 1 < beliefs.size()) {
+          hid += 1;
+          cumulative_belief += sampling_weight(hid)/belief_sum;
+        }
+        schedule.push_back(hid);
+      }
+    }
+    // Shuffle to decorrelate the hypotheses of different agents and the order in which the tree sees them
+    std::shuffle(schedule.begin(), schedule.end(), random_generator_);
+  }
+}
+
+inline const HypothesisContext& HypothesisBeliefTracker::sample_current_hypothesis(
+                                                                    const unsigned int& iteration) {
+  if(iteration >= scheduled_iterations_) {
+    return sample_current_hypothesis();
+  }
+  for (std::size_t slot = 0; slot < hypothesis_schedule_.size(); ++slot) {
+    if (!hypothesis_schedule_[slot].empty()) {
+      current_sampled_hypothesis_.set_hypothesis(slot, hypothesis_schedule_[slot][iteration]);
+    }
+  }
+  return current_sampled_hypothesis_;
+}
+
+inline const std::unordered_map<AgentIdx, std::vector<Belief>> HypothesisBeliefTracker::get_beliefs() const {
+  std::unordered_map<AgentIdx, std::vector<Belief>> beliefs;
+  for (std::size_t slot = 0; slot < tracked_beliefs_.size(); ++slot) {
+    if (!tracked_beliefs_[slot].empty()) {
+      beliefs[current_sampled_hypothesis_.agents()[slot]] = tracked_beliefs_[slot];
+    }
+  }
+  return beliefs;
+}
+
+inline const std::unordered_map<AgentIdx, std::vector<HypothesisId>> HypothesisBeliefTracker::get_pruned_hypotheses() const {
+  std::unordered_map<AgentIdx, std::vector<HypothesisId>> pruned_hypotheses;
+  for (std::size_t slot = 0; slot < tracked_beliefs_.size(); ++slot) {
+    const auto& beliefs = tracked_beliefs_[slot];
+    const Belief pruning_bound = belief_pruning_bound(beliefs);
+    std::vector<HypothesisId> pruned;
+    for (HypothesisId hid = 0; hid < beliefs.size(); ++hid) {
+      if (beliefs[hid] < pruning_bound) {
+        pruned.push_back(hid);
+      }
+    }
+    if (!pruned.empty()) {
+      pruned_hypotheses[current_sampled_hypothesis_.agents()[slot]] = std::move(pruned);
+    }
+  }
+  return pruned_hypotheses;
+}
+
+inline Belief HypothesisBeliefTracker::belief_pruning_bound(const std::vector<Belief>& beliefs) const {
+  if (belief_pruning_threshold_ <= 0.0 || beliefs.empty()) {
+    return 0.0;
+  }
+  return std::min(belief_pruning_threshold_, *std::max_element(beliefs.begin(), beliefs.end()));
+}
+
 inline std::string HypothesisBeliefTracker::sprintf() const {
   std::stringstream ss;
   // Beliefs
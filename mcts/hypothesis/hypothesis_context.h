@@ -0,0 +1,114 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_HYPOTHESIS_HYPOTHESIS_CONTEXT_H
+#define MCTS_HYPOTHESIS_HYPOTHESIS_CONTEXT_H
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mcts/state.h"
+#include "mcts/hypothesis/common.h"
+
+namespace mcts {
+
+/*
+ * Hypothesis currently assigned to each agent, shared across all hypothesis states of a search.
+ * Agent ids are mapped to contiguous slots when first seen, such that lookups during the search
+ * are array indexing. Slots are never reassigned, per agent data of the belief tracker is indexed
+ * by the same slots.
+ */
+class HypothesisContext {
+  public:
+    HypothesisContext() : slots_(), agents_(), hypotheses_() {}
+
+    explicit HypothesisContext(const std::unordered_map<AgentIdx, HypothesisId>& agents_hypothesis) :
+                    slots_(), agents_(), hypotheses_() {
+      for (const auto& agent_hypothesis : agents_hypothesis) {
+        (*this)[agent_hypothesis.first] = agent_hypothesis.second;
+      }
+    }
+
+    // Throws std::out_of_range for agents without a hypothesis, as a map lookup would
+    HypothesisId at(const AgentIdx& agent_idx) const {
+      if (agent_idx >= slots_.size() || slots_[agent_idx] == no_slot()) {
+        throw std::out_of_range("No hypothesis for agent " + std::to_string(agent_idx));
+      }
+      return hypotheses_[slots_[agent_idx]];
+    }
+
+    // Assigns a slot to unknown agents
+    HypothesisId& operator[](const AgentIdx& agent_idx) {
+      return hypotheses_[slot(agent_idx)];
+    }
+
+    std::size_t slot(const AgentIdx& agent_idx) {
+      if (agent_idx >= slots_.size()) {
+        slots_.resize(agent_idx + 1, no_slot());
+      }
+      if (slots_[agent_idx] == no_slot()) {
+        slots_[agent_idx] = agents_.size();
+        agents_.push_back(agent_idx);
+        hypotheses_.push_back(0);
+      }
+      return slots_[agent_idx];
+    }
+
+    HypothesisId get_hypothesis(const std::size_t& slot) const { return hypotheses_[slot]; }
+
+    void set_hypothesis(const std::size_t& slot, const HypothesisId& hypothesis) { hypotheses_[slot] = hypothesis; }
+
+    const std::vector<AgentIdx>& agents() const { return agents_; } // indexed by slot
+
+    std::size_t size() const { return agents_.size(); }
+
+    bool empty() const { return agents_.empty(); }
+
+  private:
+    static std::size_t no_slot() { return std::numeric_limits<std::size_t>::max(); }
+
+    std::vector<std::size_t> slots_; // indexed by agent id
+    std::vector<AgentIdx> agents_;
+    std::vector<HypothesisId> hypotheses_;
+};
+
+/*
+ * Activates a hypothesis context for the calling thread while in scope. Hypothesis states resolve the
+ * current hypotheses through the active context instead of the context shared across the search, such
+ * that iterations with different sampled hypotheses can run concurrently on the same tree.
+ * Scopes nest, a null context falls back to the shared context of the states.
+ */
+class HypothesisContextScope {
+  public:
+    explicit HypothesisContextScope(const HypothesisContext* context) : previous_(active_context()) {
+      active_context() = context;
+    }
+
+    explicit HypothesisContextScope(const HypothesisContext& context) : HypothesisContextScope(&context) {}
+
+    ~HypothesisContextScope() { active_context() = previous_; }
+
+    HypothesisContextScope(const HypothesisContextScope&) = delete;
+    HypothesisContextScope& operator=(const HypothesisContextScope&) = delete;
+
+    // Context active for the calling thread, nullptr outside of any scope
+    static const HypothesisContext* active() { return active_context(); }
+
+  private:
+    static const HypothesisContext*& active_context() {
+      static thread_local const HypothesisContext* context = nullptr;
+      return context;
+    }
+
+    const HypothesisContext* previous_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_HYPOTHESIS_HYPOTHESIS_CONTEXT_H
@@ -8,6 +8,7 @@
 #define MCTS_HYPOTHESIS_STATE_H
 
 #include "mcts/hypothesis/common.h"
+#include "mcts/hypothesis/hypothesis_context.h"
 #include "mcts/state.h"
 
 
@@ -18,7 +19,7 @@ template<typename Implementation>
 class HypothesisStateInterface : public StateInterface<Implementation>,
                                         mcts::RequiresHypothesis  {
 public:
-    HypothesisStateInterface(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) 
+    HypothesisStateInterface(const HypothesisContext& current_agents_hypothesis) 
                     : current_agents_hypothesis_(current_agents_hypothesis) {}
 
     ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const;
@@ -26,6 +27,11 @@ public:
     template<typename ActionType = ActionIdx>
     Probability get_probability(const HypothesisId& hypothesis, const AgentIdx& agent_idx, const ActionType& action) const;
 
+    // Probabilities of the action under all hypotheses of the agent, indexed by hypothesis id. Implementations
+    // may hide this default to evaluate all hypotheses at once, callers dispatch through impl().
+    template<typename ActionType = ActionIdx>
+    void get_probabilities(const AgentIdx& agent_idx, const ActionType& action, std::vector<Probability>& probabilities) const;
+
     template<typename ActionType = ActionIdx>
     ActionType get_last_action(const AgentIdx& agent_idx) const;
 
@@ -36,7 +42,7 @@ public:
     HypothesisId get_current_hypothesis(const AgentIdx& agent_idx) const;
 
 protected:
-    const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis_; // shared across all states
+    const HypothesisContext& current_agents_hypothesis_; // shared across all states, see HypothesisContextScope
 };
 
 template<typename Implementation>
@@ -52,6 +58,18 @@ Probability HypothesisStateInterface<Implementation>::get_probability(const Hypo
  return StateInterface<Implementation>::impl().get_probability(hypothesis, agent_idx, action);
 }
 
+template<typename Implementation>
+template<typename ActionType>
+void HypothesisStateInterface<Implementation>::get_probabilities(const AgentIdx& agent_idx,
+                                                                 const ActionType& action,
+                                                                 std::vector<Probability>& probabilities) const {
+ const auto& implementation = StateInterface<Implementation>::impl();
+ probabilities.resize(implementation.get_num_hypothesis(agent_idx));
+ for (HypothesisId hid = 0; hid < probabilities.size(); ++hid) {
+   probabilities[hid] = implementation.template get_probability<ActionType>(hid, agent_idx, action);
+ }
+}
+
 template<typename Implementation>
 template<typename ActionType>
 ActionType HypothesisStateInterface<Implementation>::get_last_action(const AgentIdx& agent_idx) const {
@@ -70,7 +88,8 @@ inline HypothesisId HypothesisStateInterface<Implementation>::get_num_hypothesis
 
 template<typename Implementation>
 inline HypothesisId HypothesisStateInterface<Implementation>::get_current_hypothesis(const AgentIdx& agent_idx) const {
- return current_agents_hypothesis_.at(agent_idx);
+ const HypothesisContext* active_context = HypothesisContextScope::active();
+ return (active_context ? *active_context : current_agents_hypothesis_).at(agent_idx);
 }
 
 
@@ -8,6 +8,7 @@
 #define MCTS_HYPOTHESIS_STATISTICS_H
 
 #include <cmath>
+#include <iomanip>
 #include <map>
 
 #include "mcts/mcts.h"
@@ -32,6 +33,7 @@ public:
                     latest_ego_cost_(0.0f),
                     ucb_statistics_(),
                     total_node_visits_hypothesis_(),
+                    total_pending_visits_hypothesis_(),
                     num_expanded_actions_(0),
                     total_node_visits_(0),
                     hypothesis_id_current_iteration_(HYPOTHESIS_ID_NOT_SET),
@@ -80,7 +82,9 @@ public:
             if(cost_based_action_selection_) {
                 /*  Cost-based action selection out of hypothesis action set
                 with highest ego cost to predict worst case behavior for this hypothesis (uses uct formula to also explore other actions) */
-                return get_worst_case_action(ucb_statistics_.at(hypothesis_id_current_iteration_), total_node_visits_hypothesis_.at(hypothesis_id_current_iteration_));
+                return get_worst_case_action(ucb_statistics_.at(hypothesis_id_current_iteration_),
+                                             total_node_visits_hypothesis_.at(hypothesis_id_current_iteration_) +
+                                             num_pending_visits(hypothesis_id_current_iteration_));
             } else {
                 /* Random action-selection */    
                 const auto& action_map = ucb_statistics_[hypothesis_id_current_iteration_];
@@ -91,12 +95,11 @@ public:
         }
     }
 
-    void update_from_heuristic(const NodeStatistic<HypothesisStatistic>& heuristic_statistic)
+    void update_from_heuristic(const Reward&, const Cost& heuristic_ego_cost)
     {
-        const HypothesisStatistic& heuristic_statistic_impl = heuristic_statistic.impl();
-        ego_cost_value_ = heuristic_statistic_impl.ego_cost_value_;
+        ego_cost_value_ = heuristic_ego_cost;
         latest_ego_cost_ = ego_cost_value_;
-        auto& node_visits_hypothesis = total_node_visits_hypothesis_[hypothesis_id_current_iteration_];
+        auto& node_visits_hypothesis = total_node_visits_hypothesis_[hypothesis_current_iteration()];
         MCTS_EXPECT_TRUE(total_node_visits_ == 0); // This should be the first visit
         node_visits_hypothesis += 1;
         total_node_visits_ += 1;
@@ -106,24 +109,47 @@ public:
         const HypothesisStatistic& changed_uct_statistic = changed_child_statistic.impl();
 
         //Action Value update step
-        UcbPair& ucb_pair = ucb_statistics_[hypothesis_id_current_iteration_][collected_cost_.first]; // we remembered for which action we got the reward, must be the same as during backprop, if we linked parents and childs correctly
+        const HypothesisId hypothesis_id = hypothesis_current_iteration();
+        UcbPair& ucb_pair = ucb_statistics_[hypothesis_id][collected_cost_.first]; // we remembered for which action we got the reward, must be the same as during backprop, if we linked parents and childs correctly
         //action value: Q'(s,a) = Q(s,a) + (latest_return - Q(s,a))/N =  1/(N+1 ( latest_return + N*Q(s,a))
         latest_ego_cost_ = collected_cost_.second + k_discount_factor * changed_uct_statistic.latest_ego_cost_;
         ucb_pair.action_count_ += 1;
         ucb_pair.action_ego_cost_ = ucb_pair.action_ego_cost_ + (latest_ego_cost_ - ucb_pair.action_ego_cost_) / ucb_pair.action_count_;
         VLOG_EVERY_N(6, 10) << "Agent "<< agent_idx_ <<", Action ego cost, action " << collected_cost_.first << ", C(s,a) = " << ucb_pair.action_ego_cost_;
-        auto& node_visits_hypothesis = total_node_visits_hypothesis_[hypothesis_id_current_iteration_];
+        auto& node_visits_hypothesis = total_node_visits_hypothesis_[hypothesis_id];
         node_visits_hypothesis += 1;
         ego_cost_value_ = ego_cost_value_ + (latest_ego_cost_ - ego_cost_value_) / node_visits_hypothesis;
         total_node_visits_ += 1;
     }
 
-    
-    ActionIdx get_best_action() { throw std::logic_error("Not a meaningful call for this statistic");};
 
-    void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost) {
-        ego_cost_value_ = accum_ego_cost;
-    };
+    // Pending visits are counted under the hypothesis of the iteration in flight
+    void add_pending_visit(const ActionIdx& action_idx) {
+        const HypothesisId hypothesis_id = hypothesis_current_iteration();
+        ucb_statistics_[hypothesis_id][action_idx].pending_count_ += 1;
+        total_pending_visits_hypothesis_[hypothesis_id] += 1;
+    }
+
+    void remove_pending_visit(const ActionIdx& action_idx) {
+        const HypothesisId hypothesis_id = hypothesis_current_iteration();
+        ucb_statistics_[hypothesis_id][action_idx].pending_count_ -= 1;
+        total_pending_visits_hypothesis_[hypothesis_id] -= 1;
+    }
+
+    // Reclaims the tables of hypotheses no longer sampled, the totals of the node keep their visits
+    void remove_hypotheses(const std::vector<HypothesisId>& hypotheses) {
+        for (const auto& hypothesis_id : hypotheses) {
+            const auto it = ucb_statistics_.find(hypothesis_id);
+            if (it != ucb_statistics_.end()) {
+                num_expanded_actions_ -= std::min<unsigned int>(it->second.size(), num_expanded_actions_);
+                ucb_statistics_.erase(it);
+            }
+            total_node_visits_hypothesis_.erase(hypothesis_id);
+            total_pending_visits_hypothesis_.erase(hypothesis_id);
+        }
+    }
+
+    ActionIdx get_best_action() { throw std::logic_error("Not a meaningful call for this statistic");};
 
     std::string print_edge_information(const ActionIdx& action) const { return "";};
 
@@ -136,9 +162,10 @@ public:
 
     typedef struct UcbPair
     {
-        UcbPair() : action_count_(0), action_ego_cost_(0.0f) {};
+        UcbPair() : action_count_(0), action_ego_cost_(0.0f), pending_count_(0) {};
         unsigned action_count_;
         double action_ego_cost_;
+        unsigned pending_count_; // iterations through this action with leaf evaluation in flight
     } UcbPair;
 
     ActionIdx get_worst_case_action(const std::unordered_map<ActionIdx, UcbPair>& ucb_statistics, unsigned int node_visits) const
@@ -151,7 +178,12 @@ public:
             double action_cost_normalized = (ucb_pair.second.action_ego_cost_-lower_cost_bound)/(upper_cost_bound-lower_cost_bound); 
             MCTS_EXPECT_TRUE(action_cost_normalized>=0);
             MCTS_EXPECT_TRUE(action_cost_normalized<=1);
-            const double ucb_cost = action_cost_normalized + 2 * k_exploration_constant * sqrt( (2* std::log(node_visits)) / (ucb_pair.second.action_count_)  );
+            const unsigned int action_visits = ucb_pair.second.action_count_ + ucb_pair.second.pending_count_;
+            if(ucb_pair.second.pending_count_ > 0) {
+                // Virtual loss: pending visits count as costs at the lower bound to spread in-flight iterations
+                action_cost_normalized *= double(ucb_pair.second.action_count_)/action_visits;
+            }
+            const double ucb_cost = action_cost_normalized + 2 * k_exploration_constant * sqrt( (2* std::log(node_visits)) / (action_visits)  );
             if (ucb_cost > largest_cost) {
                 largest_cost = ucb_cost;
                 worst_action = ucb_pair.first;
@@ -169,6 +201,13 @@ public:
     }
 
 private: // methods
+    // Iterations in flight resolve their hypothesis through the active context, the one remembered during
+    // selection may already belong to another iteration
+    inline HypothesisId hypothesis_current_iteration() const {
+        const HypothesisContext* active_context = HypothesisContextScope::active();
+        return active_context ? active_context->at(agent_idx_) : hypothesis_id_current_iteration_;
+    }
+
     inline bool require_progressive_widening_hypothesis_based(const HypothesisId& hypothesis_id) const {
         const auto num_expanded = num_expanded_actions(hypothesis_id);
         const auto widening_term = progressive_widening_k * std::pow(num_node_visits(hypothesis_id),
@@ -194,12 +233,19 @@ private: // methods
     inline unsigned int num_node_visits(const HypothesisId& hypothesis_id) const {
         return total_node_visits_hypothesis_.at(hypothesis_id);
     }
+
+    // How many iterations in flight passed this statistic under specific hypothesis
+    inline unsigned int num_pending_visits(const HypothesisId& hypothesis_id) const {
+        const auto it = total_pending_visits_hypothesis_.find(hypothesis_id);
+        return it != total_pending_visits_hypothesis_.end() ? it->second : 0;
+    }
 private: // members
 
     double ego_cost_value_; // average over all previous actions and heuristic calls going out from this node
     double latest_ego_cost_;   // tracks the ego cost during backpropagation (one action)
     std::unordered_map<HypothesisId, std::unordered_map<ActionIdx, UcbPair>> ucb_statistics_; // first: action selection count, action-ego_cost_qvalue
     std::unordered_map<HypothesisId, unsigned int> total_node_visits_hypothesis_;
+    std::unordered_map<HypothesisId, unsigned int> total_pending_visits_hypothesis_;
     HypothesisId hypothesis_id_current_iteration_; // persist hypothesis id between action selection and backpropagation
     unsigned int total_node_visits_;
     unsigned int num_expanded_actions_;
@@ -0,0 +1,179 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_LEAF_EVALUATION_PIPELINE_H
+#define MCTS_LEAF_EVALUATION_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "common.h"
+#include "heuristic.h"
+#include "hypothesis/hypothesis_context.h"
+#include "mcts_parameters.h"
+#include "thread_pool.h"
+
+namespace mcts {
+
+/*
+ * Evaluates expanded leaves with the heuristic on a pool of evaluator threads. Leaves are collected
+ * into batches, each evaluator thread works on its own copy of the heuristic, reseeded per thread.
+ * Without evaluator threads, full batches are evaluated in the search thread. Only the search thread
+ * pushes leaves and pops evaluations, the tree is never touched by the evaluator threads
+ * except for reading the (immutable) states of the leaves. Leaves of a hypothesis-based search carry
+ * the hypotheses sampled for their iteration, they are evaluated one by one within its context unless
+ * the heuristic ignores the hypotheses (IgnoresHypothesisContext).
+ * An exception thrown by the heuristic on an evaluator thread is rethrown on the search thread
+ * by the next pop.
+ */
+template<class S, class SE, class SO, class H>
+class LeafEvaluationPipeline
+{
+public:
+    using StageNodeSPtr = std::shared_ptr<StageNode<S,SE,SO,H>>;
+    using HypothesisContextPtr = const HypothesisContext*; // owned by the search, outlives the pipeline
+
+    LeafEvaluationPipeline(const H& heuristic, const MctsParameters& mcts_parameters) :
+            batch_size_(std::max(mcts_parameters.leaf_evaluation_pipeline.BATCH_SIZE, 1u)),
+            heuristics_(std::max(mcts_parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS, 1u), heuristic),
+            batch_(),
+            batch_contexts_(),
+            num_pending_(0),
+            completed_(),
+            evaluation_error_(),
+            mutex_(),
+            evaluation_completed_(),
+            evaluator_pool_(mcts_parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS) {
+        for (unsigned int worker_idx = 0; worker_idx < heuristics_.size(); ++worker_idx) {
+            heuristics_[worker_idx].seed(worker_idx);
+        }
+    }
+
+    // Queues a leaf for evaluation, a batch is handed to the evaluators once it is full
+    void push(const StageNodeSPtr& leaf, const HypothesisContextPtr& hypothesis_context = nullptr) {
+        batch_.push_back(leaf);
+        batch_contexts_.push_back(hypothesis_context);
+        num_pending_ += 1;
+        if (batch_.size() >= batch_size_) {
+            flush();
+        }
+    }
+
+    // Hands an incomplete batch to the evaluators
+    void flush() {
+        if (batch_.empty()) {
+            return;
+        }
+        auto batch = std::make_shared<std::vector<StageNodeSPtr>>(std::move(batch_));
+        auto batch_contexts = std::make_shared<std::vector<HypothesisContextPtr>>(std::move(batch_contexts_));
+        batch_.clear();
+        batch_contexts_.clear();
+        auto evaluate = [this, batch, batch_contexts](const unsigned int& worker_idx) {
+            std::vector<HeuristicValue> heuristic_values;
+            try {
+                if (batch_contexts->front() && !std::is_base_of<IgnoresHypothesisContext, H>::value) {
+                    heuristic_values.reserve(batch->size());
+                    for (std::size_t idx = 0; idx < batch->size(); ++idx) {
+                        HypothesisContextScope scope(batch_contexts->at(idx));
+                        heuristic_values.push_back(heuristics_[worker_idx].calculate_heuristic_values(batch->at(idx)));
+                    }
+                } else {
+                    heuristics_[worker_idx].calculate_heuristic_values_batch(*batch, heuristic_values);
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!evaluation_error_) {
+                        evaluation_error_ = std::current_exception();
+                    }
+                }
+                evaluation_completed_.notify_one();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (std::size_t idx = 0; idx < batch->size(); ++idx) {
+                    completed_.push_back(Evaluation{batch->at(idx), std::move(heuristic_values[idx]),
+                                                    batch_contexts->at(idx)});
+                }
+            }
+            evaluation_completed_.notify_one();
+        };
+        if (evaluator_pool_.size() > 0) {
+            evaluator_pool_.submit(evaluate);
+        } else {
+            evaluate(0);
+        }
+    }
+
+    // Returns false if no evaluation has completed yet, rethrows a failed evaluation
+    bool try_pop(StageNodeSPtr& leaf, HeuristicValue& heuristic_value, HypothesisContextPtr& hypothesis_context) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrow_evaluation_error();
+        if (completed_.empty()) {
+            return false;
+        }
+        pop_completed(leaf, heuristic_value, hypothesis_context);
+        return true;
+    }
+
+    // Blocks until the next evaluation is completed, requires pending leaves. Rethrows a failed evaluation
+    void wait_and_pop(StageNodeSPtr& leaf, HeuristicValue& heuristic_value, HypothesisContextPtr& hypothesis_context) {
+        MCTS_EXPECT_TRUE(num_pending_ > 0);
+        flush();
+        std::unique_lock<std::mutex> lock(mutex_);
+        evaluation_completed_.wait(lock, [this]() { return !completed_.empty() || evaluation_error_; });
+        rethrow_evaluation_error();
+        pop_completed(leaf, heuristic_value, hypothesis_context);
+    }
+
+    // Leaves pushed but not yet popped
+    unsigned int num_pending() const { return num_pending_; }
+
+private:
+    struct Evaluation {
+        StageNodeSPtr leaf;
+        HeuristicValue heuristic_value;
+        HypothesisContextPtr hypothesis_context;
+    };
+
+    // The leaves of a failed batch are never completed, the search can not continue
+    void rethrow_evaluation_error() {
+        if (evaluation_error_) {
+            std::rethrow_exception(evaluation_error_);
+        }
+    }
+
+    void pop_completed(StageNodeSPtr& leaf, HeuristicValue& heuristic_value, HypothesisContextPtr& hypothesis_context) {
+        leaf = std::move(completed_.front().leaf);
+        heuristic_value = std::move(completed_.front().heuristic_value);
+        hypothesis_context = std::move(completed_.front().hypothesis_context);
+        completed_.pop_front();
+        num_pending_ -= 1;
+    }
+
+    const unsigned int batch_size_;
+    std::vector<H> heuristics_; // one per evaluator thread, one for the search thread without evaluator threads
+    std::vector<StageNodeSPtr> batch_;
+    std::vector<HypothesisContextPtr> batch_contexts_; // empty contexts outside of hypothesis-based search
+    unsigned int num_pending_;
+
+    std::deque<Evaluation> completed_;
+    std::exception_ptr evaluation_error_; // first exception thrown by the heuristic
+    std::mutex mutex_;
+    std::condition_variable evaluation_completed_;
+
+    ThreadPool evaluator_pool_; // last member, joined before the heuristics and queues are destroyed
+};
+
+} // namespace mcts
+
+#endif // MCTS_LEAF_EVALUATION_PIPELINE_H
@@ -10,10 +10,14 @@
 
 #include "stage_node.h"
 #include "heuristic.h"
+#include "leaf_evaluation_pipeline.h"
 #include "hypothesis/hypothesis_belief_tracker.h"
 #include <chrono>  // for high_resolution_clock
 #include "common.h"
 #include "mcts_parameters.h"
+#include "object_pool.h"
+#include "random_generator.h"
+#include <numeric>
 #include <string>
  
 
@@ -35,10 +39,31 @@ public:
     using StageNodeWPtr = std::weak_ptr<StageNode<S,SE,SO, H>>;
 
     Mcts(const MctsParameters& mcts_parameters) : root_(),
+                                                  root_retained_(false),
+                                                  transposition_table_(),
                                                   num_iterations_(0),
+                                                  num_rollouts_(0),
                                                   mcts_parameters_(mcts_parameters), 
-                                                  heuristic_(mcts_parameters)
-                                                  {}
+                                                  heuristic_(mcts_parameters_),
+                                                  random_stream_(mcts_parameters.RANDOM_SEED),
+                                                  state_pool_(std::make_shared<BlockPool>(mcts_parameters.MAX_NUMBER_OF_ITERATIONS))
+                                                  {
+                                                      expect_valid_parameters();
+                                                  }
+
+    // Uses a copy of a preconfigured heuristic, e.g. one wrapping a learned value function
+    Mcts(const MctsParameters& mcts_parameters, const H& heuristic) : root_(),
+                                                  root_retained_(false),
+                                                  transposition_table_(),
+                                                  num_iterations_(0),
+                                                  num_rollouts_(0),
+                                                  mcts_parameters_(mcts_parameters),
+                                                  heuristic_(heuristic),
+                                                  random_stream_(mcts_parameters.RANDOM_SEED),
+                                                  state_pool_(std::make_shared<BlockPool>(mcts_parameters.MAX_NUMBER_OF_ITERATIONS))
+                                                  {
+                                                      expect_valid_parameters();
+                                                  }
 
     ~Mcts() {}
     
@@ -47,8 +72,21 @@ public:
     search(const S& current_state, HypothesisBeliefTracker& belief_tracker);
 
     void search(const S& current_state);
+
+    // Keeps the subtree of the executed joint action with all its statistics as root of the next search,
+    // which then runs REUSE_TREE_ITERATIONS iterations. The state passed to the next search must be the one
+    // reached by the joint action. Returns false if the joint action was not expanded or reuse is disabled,
+    // the next search then starts a new tree.
+    bool reroot(const JointAction& joint_action);
+
+    // Reclaims the statistics of hypotheses pruned by the belief tracker from the current tree
+    template< class Q = S>
+    typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+    prune_hypotheses(const HypothesisBeliefTracker& belief_tracker);
     
     unsigned int numIterations();
+    unsigned int numRollouts();
+    unsigned int numNodes(); // nodes created since the current tree was started
     unsigned int searchTime();
     std::string nodeInfo();
     ActionIdx returnBestAction();
@@ -58,18 +96,64 @@ public:
 
 private:
 
+    void expect_valid_parameters() const {
+        // Pending visits are backpropagated along the parents of a leaf, which are not unique with transpositions
+        MCTS_EXPECT_TRUE(!(mcts_parameters_.TRANSPOSITION_TABLE && uses_pipeline()),
+                         "TRANSPOSITION_TABLE is not supported by the pipelined search");
+    }
+
+    // Leaves are evaluated on evaluator threads or in batches
+    bool uses_pipeline() const {
+        return mcts_parameters_.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS > 0 ||
+               mcts_parameters_.leaf_evaluation_pipeline.BATCH_SIZE > 1;
+    }
+
+    bool uses_transposition_table() const {
+        return mcts_parameters_.TRANSPOSITION_TABLE && !uses_pipeline();
+    }
+
     void iterate(const StageNodeSPtr& root_node);
 
+    // Starts a new tree unless a subtree was kept by reroot(), returns the iterations of this search
+    unsigned int init_root(const S& current_state);
+
+    template< class Q = S>
+    typename std::enable_if<std::is_base_of<SupportsStatePool, Q>::value, std::shared_ptr<S>>::type
+    clone_root_state(const S& current_state) const { return current_state.clone(state_pool_); }
+
+    template< class Q = S>
+    typename std::enable_if<!std::is_base_of<SupportsStatePool, Q>::value, std::shared_ptr<S>>::type
+    clone_root_state(const S& current_state) const { return current_state.clone(); }
+
+    void search_pipelined(const std::chrono::high_resolution_clock::time_point& start,
+                          const unsigned int& max_iterations,
+                          HypothesisBeliefTracker* belief_tracker = nullptr);
+    bool select_leaf(const StageNodeSPtr& root_node, StageNodeSPtr& leaf) const;
+    void add_pending_visits(const StageNodeSPtr& leaf) const;
+    void backpropagate_pending(const StageNodeSPtr& leaf) const;
+
     StageNodeSPtr root_;
 
+    bool root_retained_;
+
+    TranspositionTable<StageNode<S,SE,SO,H>> transposition_table_; // used if TRANSPOSITION_TABLE is set
+
     unsigned int num_iterations_;
 
+    unsigned int num_rollouts_; // rollouts the heuristic used for all leaves of the last search
+
     unsigned int search_time_;
 
     const MctsParameters mcts_parameters_;
 
     H heuristic_;
 
+    RandomStream random_stream_; // active during the search, e.g. for actions of other agents sampled in selection
+
+    // Memory of the states of the tree and of rollouts. A search adds one node per iteration, free blocks
+    // are kept up to MAX_NUMBER_OF_ITERATIONS per size to reuse about the states of a released tree.
+    std::shared_ptr<BlockPool> state_pool_;
+
     std::string sprintf(const StageNodeSPtr& root_node) const;
 
     MCTS_TEST
@@ -80,74 +164,120 @@ template<class Q>
 typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
 Mcts<S, SE, SO, H>::search(const S& current_state, HypothesisBeliefTracker& belief_tracker) {
     auto start = std::chrono::high_resolution_clock::now();
-    StageNode<S,SE, SO, H>::reset_counter();
+    RandomStreamScope random_stream_scope(random_stream_);
 
-    const auto max_iterations = mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
+    const auto max_iterations = init_root(current_state);
     const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
 
-    root_ = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>, const JointAction&,
-            const unsigned int&> (nullptr, current_state.clone(),JointAction(),0,  mcts_parameters_);
     num_iterations_ = 0;
-    while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
-        belief_tracker.sample_current_hypothesis();
-        iterate(root_);
-        num_iterations_ += 1;
+    num_rollouts_ = 0;
+    belief_tracker.schedule_hypotheses(max_iterations);
+    if (uses_pipeline()) {
+        search_pipelined(start, max_iterations, &belief_tracker);
+    } else {
+        while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
+            belief_tracker.sample_current_hypothesis(num_iterations_);
+            iterate(root_);
+            num_iterations_ += 1;
+        }
     }
     search_time_ = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count();
 }
 
+template<class S, class SE, class SO, class H>
+template<class Q>
+typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+Mcts<S, SE, SO, H>::prune_hypotheses(const HypothesisBeliefTracker& belief_tracker) {
+    const auto pruned_hypotheses = belief_tracker.get_pruned_hypotheses();
+    if (!root_ || pruned_hypotheses.empty()) {
+        return;
+    }
+    root_->visit_other_int_nodes([&pruned_hypotheses](IntermediateNode<S, SO>& other_int_node) {
+        const auto it = pruned_hypotheses.find(other_int_node.get_agent_idx());
+        if (it != pruned_hypotheses.end()) {
+            other_int_node.remove_hypotheses(it->second);
+        }
+    });
+}
+
 template<class S, class SE, class SO, class H>
 void Mcts<S,SE,SO,H>::search(const S& current_state)
 {
     auto start = std::chrono::high_resolution_clock::now();
+    RandomStreamScope random_stream_scope(random_stream_);
 
-    StageNode<S,SE, SO, H>::reset_counter();
-
-    const auto max_iterations = mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
+    const auto max_iterations = init_root(current_state);
     const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
 
-    root_ = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>, const JointAction&,
-            const unsigned int&> (nullptr, current_state.clone(), JointAction(),0, mcts_parameters_);
     num_iterations_ = 0;
-    while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
-        iterate(root_);
-        num_iterations_ += 1;
+    num_rollouts_ = 0;
+    if (uses_pipeline()) {
+        search_pipelined(start, max_iterations);
+    } else {
+        while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
+            iterate(root_);
+            num_iterations_ += 1;
+        }
     }
     search_time_ = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count();
 }
 
+template<class S, class SE, class SO, class H>
+bool Mcts<S,SE,SO,H>::reroot(const JointAction& joint_action)
+{
+    // Siblings of the kept subtree are released with the former root
+    root_ = (root_ && mcts_parameters_.REUSE_TREE_ITERATIONS > 0) ? root_->get_child(joint_action) : nullptr;
+    root_retained_ = static_cast<bool>(root_);
+    return root_retained_;
+}
+
+template<class S, class SE, class SO, class H>
+unsigned int Mcts<S,SE,SO,H>::init_root(const S& current_state)
+{
+    if (root_retained_) {
+        root_retained_ = false;
+        return mcts_parameters_.REUSE_TREE_ITERATIONS;
+    }
+    StageNode<S,SE, SO, H>::reset_counter();
+    root_ = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>, const JointAction&,
+            const unsigned int&> (nullptr, clone_root_state(current_state), JointAction(),0, mcts_parameters_);
+    transposition_table_.clear();
+    if (uses_transposition_table()) {
+        transposition_table_.insert(root_);
+    }
+    return mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
+}
+
 template<class S, class SE, class SO, class H>
 void Mcts<S,SE,SO,H>::iterate(const StageNodeSPtr& root_node)
 {
     StageNodeSPtr node = root_node;
-    StageNodeSPtr node_p;
+    auto transposition_table = uses_transposition_table() ? &transposition_table_ : nullptr;
 
     // --------------Select & Expand  -----------------
     // We descend the tree for all joint actions already available -> last node is the newly expanded one
-    while(node->select_or_expand(node));
+    // The path is remembered, as nodes linked by the transposition table have several parents
+    std::vector<StageNodeSPtr> path{root_node};
+    while(node->select_or_expand(node, transposition_table)) {
+        path.push_back(node);
+    }
+    if(node != path.back()) {
+        path.push_back(node);
+    }
 
     // -------------- Heuristic Update ----------------
     // Heuristic until terminal node only if state not terminal
     if(!node->get_state()->is_terminal()) {
-      const auto& heuristics = heuristic_.calculate_heuristic_values(node);
-      node->update_statistics(heuristics.first, heuristics.second);
+      const HeuristicValue heuristic_value = heuristic_.calculate_heuristic_values(node);
+      node->update_statistics(heuristic_value);
+      num_rollouts_ += heuristic_value.num_rollouts;
     }
 
     // --------------- Backpropagation ----------------
-    // Backpropagate, starting from parent node of newly expanded node
-    node_p = node->get_parent().lock();
-    while(true)
+    // Backpropagate along the selected path, starting from parent node of newly expanded node
+    for (std::size_t idx = path.size() - 1; idx > 0; --idx)
     {
-        node_p->update_statistics(node);
-        if(node_p->is_root())
-        {
-            break;
-        }
-        else
-        {
-            node = node->get_parent().lock();
-            node_p = node_p->get_parent().lock();
-        }
+        path[idx-1]->update_statistics(path[idx]);
     }
 
 #ifdef PLAN_DEBUG_INFO
@@ -155,6 +285,124 @@ void Mcts<S,SE,SO,H>::iterate(const StageNodeSPtr& root_node)
 #endif
 }
 
+template<class S, class SE, class SO, class H>
+void Mcts<S,SE,SO,H>::search_pipelined(const std::chrono::high_resolution_clock::time_point& start,
+                                       const unsigned int& max_iterations,
+                                       HypothesisBeliefTracker* belief_tracker)
+{
+    const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
+    // Allow two batches per evaluator thread in flight, the next batch is ready when an evaluator finishes.
+    // Without evaluator threads, a batch is evaluated in the search thread once it is full.
+    const auto& pipeline_parameters = mcts_parameters_.leaf_evaluation_pipeline;
+    const unsigned int max_pending_leaves = 2 * std::max(pipeline_parameters.NUM_EVALUATOR_THREADS, 1u) *
+                                            std::max(pipeline_parameters.BATCH_SIZE, 1u);
+
+    LeafEvaluationPipeline<S,SE,SO,H> pipeline(heuristic_, mcts_parameters_);
+    StageNodeSPtr leaf;
+    HeuristicValue heuristic_value;
+    // Each iteration of a hypothesis-based search works on its own copy of the sampled hypotheses,
+    // which stays active for the iteration from selection to backpropagation. Copies are taken from
+    // a fixed pool with one context per leaf in flight.
+    std::vector<HypothesisContext> hypothesis_contexts(belief_tracker ? max_pending_leaves : 0);
+    std::vector<std::size_t> free_hypothesis_contexts(hypothesis_contexts.size());
+    std::iota(free_hypothesis_contexts.begin(), free_hypothesis_contexts.end(), 0);
+    const HypothesisContext* hypothesis_context = nullptr;
+    // Iterations are counted when their backpropagation is completed
+    auto complete_iteration = [&]() {
+        HypothesisContextScope scope(hypothesis_context);
+        leaf->set_evaluation_pending(false);
+        leaf->update_statistics(heuristic_value);
+        num_rollouts_ += heuristic_value.num_rollouts;
+        backpropagate_pending(leaf);
+        num_iterations_ += 1;
+        if (hypothesis_context) {
+            free_hypothesis_contexts.push_back(hypothesis_context - hypothesis_contexts.data());
+        }
+    };
+
+    unsigned int num_started_iterations = 0;
+    while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
+        // --------------Select & Expand  -----------------
+        if (num_started_iterations < max_iterations && pipeline.num_pending() < max_pending_leaves) {
+            HypothesisContext* sampled_context = nullptr;
+            if (belief_tracker) {
+                sampled_context = &hypothesis_contexts[free_hypothesis_contexts.back()];
+                *sampled_context = belief_tracker->sample_current_hypothesis(num_started_iterations);
+            }
+            HypothesisContextScope scope(sampled_context);
+            if (select_leaf(root_, leaf)) {
+                num_started_iterations += 1;
+                add_pending_visits(leaf);
+                if (leaf->get_state()->is_terminal()) {
+                    backpropagate_pending(leaf);
+                    num_iterations_ += 1;
+                } else {
+                    leaf->set_evaluation_pending(true);
+                    pipeline.push(leaf, sampled_context);
+                    if (sampled_context) {
+                        free_hypothesis_contexts.pop_back();
+                    }
+                }
+            } else {
+                // Selection ran into a leaf in flight, wait for an evaluation instead of repeating the same path
+                pipeline.wait_and_pop(leaf, heuristic_value, hypothesis_context);
+                complete_iteration();
+            }
+        } else {
+            pipeline.wait_and_pop(leaf, heuristic_value, hypothesis_context);
+            complete_iteration();
+        }
+
+        // --------------- Backpropagation ----------------
+        while (pipeline.try_pop(leaf, heuristic_value, hypothesis_context)) {
+            complete_iteration();
+        }
+    }
+
+    // Started iterations are completed to leave no pending visits in the tree
+    while (pipeline.num_pending() > 0) {
+        pipeline.wait_and_pop(leaf, heuristic_value, hypothesis_context);
+        complete_iteration();
+    }
+}
+
+template<class S, class SE, class SO, class H>
+bool Mcts<S,SE,SO,H>::select_leaf(const StageNodeSPtr& root_node, StageNodeSPtr& leaf) const
+{
+    // Returns false if selection reaches a leaf whose evaluation is still in flight
+    leaf = root_node;
+    while(leaf->select_or_expand(leaf)) {
+        if (leaf->is_evaluation_pending()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class S, class SE, class SO, class H>
+void Mcts<S,SE,SO,H>::add_pending_visits(const StageNodeSPtr& leaf) const
+{
+    StageNodeSPtr node = leaf;
+    StageNodeSPtr node_p = node->get_parent().lock();
+    while (node_p) {
+        node_p->add_pending_visit(node->get_joint_action());
+        node = node_p;
+        node_p = node->get_parent().lock();
+    }
+}
+
+template<class S, class SE, class SO, class H>
+void Mcts<S,SE,SO,H>::backpropagate_pending(const StageNodeSPtr& leaf) const
+{
+    StageNodeSPtr node = leaf;
+    StageNodeSPtr node_p = node->get_parent().lock();
+    while (node_p) {
+        node_p->update_pending_statistics(node);
+        node = node_p;
+        node_p = node->get_parent().lock();
+    }
+}
+
 template<class S, class SE, class SO, class H>
 std::string Mcts<S,SE,SO,H>::sprintf(const StageNodeSPtr& root_node) const
 {
@@ -167,6 +415,16 @@ unsigned int Mcts<S,SE,SO,H>::numIterations(){
     return this->num_iterations_;
 }
 
+template<class S, class SE, class SO, class H>
+unsigned int Mcts<S,SE,SO,H>::numRollouts(){
+    return this->num_rollouts_;
+}
+
+template<class S, class SE, class SO, class H>
+unsigned int Mcts<S,SE,SO,H>::numNodes(){
+    return StageNode<S,SE,SO,H>::get_num_nodes();
+}
+
 template<class S, class SE, class SO, class H>
 unsigned int Mcts<S,SE,SO,H>::searchTime(){
     return this->search_time_;
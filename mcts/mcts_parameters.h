@@ -20,10 +20,17 @@ struct MctsParameters{
   unsigned int RANDOM_SEED;
   unsigned int MAX_NUMBER_OF_ITERATIONS;
   unsigned int MAX_SEARCH_TIME;
+  unsigned int REUSE_TREE_ITERATIONS; // 0 = new tree for each search, otherwise iterations of a search continuing a rerooted tree
+  bool TRANSPOSITION_TABLE; // equal states at equal depth share a node, requires states supporting hashing, not supported by the pipelined search
 
   struct RandomHeuristicParameters {
       double MAX_SEARCH_TIME;
       unsigned int MAX_NUMBER_OF_ITERATIONS;
+      unsigned int ROLLOUT_HORIZON; // 0 = rollout until terminal, otherwise truncate and bootstrap the remaining return
+      bool COMMON_RANDOM_NUMBERS; // rollouts from siblings use the same random streams, requires states supporting random seeding
+      unsigned int MAX_NUMBER_OF_ROLLOUTS; // rollouts per leaf, their mean is the leaf estimate
+      double ROLLOUT_STANDARD_ERROR_THRESHOLD; // stop rollouts of a leaf once standard errors of ego return and cost are below
+      double MAX_LEAF_EVALUATION_TIME; // time slice in ms for all rollouts of a leaf, at least one rollout is done
   };
 
   struct UctStatisticParameters {
@@ -48,12 +55,21 @@ struct MctsParameters{
       float PROBABILITY_DISCOUNT;
       int POSTERIOR_TYPE;
       std::unordered_map<unsigned int, unsigned int> FIXED_HYPOTHESIS_SET;
+      bool STRATIFIED_HYPOTHESIS_SCHEDULE; // pre-sample stratified hypotheses for all MAX_NUMBER_OF_ITERATIONS of a search
+      unsigned int NUM_BELIEF_UPDATE_THREADS; // 0 = update the beliefs of all agents in the calling thread
+      double BELIEF_PRUNING_THRESHOLD; // 0 = no pruning, hypotheses with lower belief are not sampled
+  };
+
+  struct LeafEvaluationPipelineParameters {
+      unsigned int NUM_EVALUATOR_THREADS; // 0 = evaluate leaves in the search thread
+      unsigned int BATCH_SIZE; // number of leaves passed to one heuristic call, > 1 batches leaves also without evaluator threads
   };
 
   HypothesisStatisticParameters hypothesis_statistic;
   UctStatisticParameters uct_statistic;
   RandomHeuristicParameters random_heuristic;
   HypothesisBeliefTrackerParameters hypothesis_belief_tracker;
+  LeafEvaluationPipelineParameters leaf_evaluation_pipeline;
 };
 
 
@@ -63,9 +79,16 @@ inline MctsParameters mcts_default_parameters() {
   parameters.RANDOM_SEED = 1000;
   parameters.MAX_NUMBER_OF_ITERATIONS = 10000;
   parameters.MAX_SEARCH_TIME = 1000;
+  parameters.REUSE_TREE_ITERATIONS = 0;
+  parameters.TRANSPOSITION_TABLE = false;
   
   parameters.random_heuristic.MAX_SEARCH_TIME = 10;
   parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000;
+  parameters.random_heuristic.ROLLOUT_HORIZON = 0;
+  parameters.random_heuristic.COMMON_RANDOM_NUMBERS = false;
+  parameters.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 1;
+  parameters.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.0;
+  parameters.random_heuristic.MAX_LEAF_EVALUATION_TIME = 100;
 
   parameters.uct_statistic.LOWER_BOUND = -1000;
   parameters.uct_statistic.UPPER_BOUND = 100;
@@ -84,6 +107,12 @@ inline MctsParameters mcts_default_parameters() {
   parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 1.0f;
   parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = 0; // = HypothesisBeliefTracker::PRODUCT;
   parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET = {};
+  parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = false;
+  parameters.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS = 0;
+  parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.0;
+
+  parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 0;
+  parameters.leaf_evaluation_pipeline.BATCH_SIZE = 1;
 
   return parameters;
 }
@@ -31,10 +31,12 @@ public:
     template <class S>
     ActionIdx choose_next_action(const StateInterface<S>& state);
     void update_statistic(const NodeStatistic<Implementation>& changed_child_statistic); // update statistic during backpropagation from child node
-    void update_from_heuristic(const NodeStatistic<Implementation>& heuristic_statistic); // update statistic during backpropagation from heuristic estimate
+    void update_from_heuristic(const Reward& heuristic_return, const Cost& heuristic_ego_cost); // update statistic during backpropagation from heuristic estimate
     ActionIdx get_best_action();
 
-    void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost);
+    // Visits of iterations whose leaf evaluation is still in flight, see LeafEvaluationPipeline
+    void add_pending_visit(const ActionIdx& action_idx);
+    void remove_pending_visit(const ActionIdx& action_idx);
 
     void collect(const Reward& reward,  const Cost& cost, const ActionIdx& action_idx);
 
@@ -90,19 +92,24 @@ void NodeStatistic<Implementation>::update_statistic(const NodeStatistic<Impleme
 }
 
 template <class Implementation>
-void NodeStatistic<Implementation>::update_from_heuristic(const NodeStatistic<Implementation>& heuristic_statistic) {
-    return impl().update_from_heuristic(heuristic_statistic);
+void NodeStatistic<Implementation>::update_from_heuristic(const Reward& heuristic_return, const Cost& heuristic_ego_cost) {
+    return impl().update_from_heuristic(heuristic_return, heuristic_ego_cost);
 }
 
 template <class Implementation>
-void NodeStatistic<Implementation>::collect(const mcts::Reward &reward, const mcts::Cost& cost, const ActionIdx& action_idx) {
-    collected_reward_= std::pair<ActionIdx, Reward>(action_idx, reward);
-    collected_cost_= std::pair<ActionIdx, Reward>(action_idx, cost);
+void NodeStatistic<Implementation>::add_pending_visit(const ActionIdx& action_idx) {
+    return impl().add_pending_visit(action_idx);
 }
 
 template <class Implementation>
-void NodeStatistic<Implementation>::set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost) {
-    return impl().set_heuristic_estimate(accum_rewards, accum_ego_cost);
+void NodeStatistic<Implementation>::remove_pending_visit(const ActionIdx& action_idx) {
+    return impl().remove_pending_visit(action_idx);
+}
+
+template <class Implementation>
+void NodeStatistic<Implementation>::collect(const mcts::Reward &reward, const mcts::Cost& cost, const ActionIdx& action_idx) {
+    collected_reward_= std::pair<ActionIdx, Reward>(action_idx, reward);
+    collected_cost_= std::pair<ActionIdx, Reward>(action_idx, cost);
 }
 
 
@@ -0,0 +1,144 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_OBJECT_POOL_H
+#define MCTS_OBJECT_POOL_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mcts {
+
+// Recycles memory blocks by their size, e.g. of states and their per agent buffers. Blocks released by any
+// thread are kept for reuse up to max_free_blocks per size, further blocks are returned to the heap.
+// Only a few sizes are expected, free lists are looked up linearly. A pool is meant to serve mainly one
+// thread, e.g. the search or one evaluator thread, the lock then stays uncontended.
+class BlockPool
+{
+public:
+    explicit BlockPool(const std::size_t& max_free_blocks = std::numeric_limits<std::size_t>::max()) :
+            mutex_(), max_free_blocks_(max_free_blocks), free_lists_() {}
+
+    ~BlockPool() {
+        for (auto& free_list : free_lists_) {
+            for (auto block : free_list.blocks) {
+                ::operator delete(block);
+            }
+        }
+    }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    void* allocate(const std::size_t& size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& blocks = free_list(size).blocks;
+            if (!blocks.empty()) {
+                void* block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, const std::size_t& size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& blocks = free_list(size).blocks;
+            if (blocks.size() < max_free_blocks_) {
+                blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    std::size_t num_free_blocks() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t num_free_blocks = 0;
+        for (const auto& free_list : free_lists_) {
+            num_free_blocks += free_list.blocks.size();
+        }
+        return num_free_blocks;
+    }
+
+private:
+    struct FreeList {
+        std::size_t block_size;
+        std::vector<void*> blocks;
+    };
+
+    // Requires the lock
+    FreeList& free_list(const std::size_t& size) {
+        for (auto& free_list : free_lists_) {
+            if (free_list.block_size == size) {
+                return free_list;
+            }
+        }
+        free_lists_.push_back(FreeList{size, std::vector<void*>()});
+        return free_lists_.back();
+    }
+
+    mutable std::mutex mutex_;
+    const std::size_t max_free_blocks_;
+    std::vector<FreeList> free_lists_;
+};
+
+// Allocator drawing from a shared block pool, for use with std::allocate_shared and containers. Each
+// allocation keeps the pool alive through the copy of the allocator stored with it. Without a pool,
+// memory is drawn from the heap.
+template<typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() : pool_() {}
+
+    explicit PoolAllocator(const std::shared_ptr<BlockPool>& pool) : pool_(pool) {}
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool_(other.pool_) {}
+
+    T* allocate(const std::size_t& n) {
+        if (pool_) {
+            return static_cast<T*>(pool_->allocate(n*sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate(T* object, const std::size_t& n) {
+        if (pool_) {
+            pool_->deallocate(object, n*sizeof(T));
+        } else {
+            ::operator delete(object);
+        }
+    }
+
+    const std::shared_ptr<BlockPool>& pool() const { return pool_; }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return pool_ == other.pool_; }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return pool_ != other.pool_; }
+
+private:
+    template<typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<BlockPool> pool_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_OBJECT_POOL_H
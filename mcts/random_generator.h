@@ -21,6 +21,38 @@ namespace mcts {
         ~RandomGenerator() {}
 
     };
+
+    // Stream of random numbers behind the sampled actions of other agents
+    typedef std::minstd_rand RandomStream;
+
+    /*
+     * Activates a random stream owned by the caller, e.g. the search or a rollout of the heuristic, for the
+     * calling thread while in scope. States draw the random numbers behind other agents' actions from the
+     * active stream and hold no random state of their own, such that const states can be shared across
+     * iterations and threads. Scopes nest.
+     */
+    class RandomStreamScope {
+    public:
+        explicit RandomStreamScope(RandomStream& random_stream) : previous_(active_stream()) {
+            active_stream() = &random_stream;
+        }
+
+        ~RandomStreamScope() { active_stream() = previous_; }
+
+        RandomStreamScope(const RandomStreamScope&) = delete;
+        RandomStreamScope& operator=(const RandomStreamScope&) = delete;
+
+        // Stream active for the calling thread, nullptr outside of any scope
+        static RandomStream* active() { return active_stream(); }
+
+    private:
+        static RandomStream*& active_stream() {
+            static thread_local RandomStream* random_stream = nullptr;
+            return random_stream;
+        }
+
+        RandomStream* previous_;
+    };
 } // namespace mcts
 
 
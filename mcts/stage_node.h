@@ -11,8 +11,11 @@
 #include "state.h"
 #include "intermediate_node.h"
 #include "node_statistic.h"
+#include "heuristic.h"
+#include "transposition_table.h"
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <boost/functional/hash.hpp>
 #include <iostream>
 #include "common.h"
@@ -66,9 +69,15 @@ struct container_hash {
         const unsigned int max_num_joint_actions_;
         const unsigned int id_;
         const unsigned int depth_;
+        bool evaluation_pending_; // heuristic evaluation of this leaf is in flight
         
         static unsigned int num_nodes_;
 
+        void collect_rewards(const JointAction& joint_action);
+
+        template<class Function>
+        void visit_other_int_nodes(const Function& function, std::unordered_set<const StageNode*>& visited);
+
         const MctsParameters & mcts_parameters_;
 
     public:
@@ -76,14 +85,23 @@ struct container_hash {
                   const JointAction& joint_action, const unsigned int& depth,
                   const MctsParameters & mcts_parameters);
         ~StageNode();
-        bool select_or_expand(StageNodeSPtr& next_node);
-        void update_statistics(const SE& ego_heuristic_estimate, const std::unordered_map<AgentIdx, SO>& other_heuristic_estimates);
+        // Links to a node of the transposition table instead of expanding an equal state, if a table is given
+        bool select_or_expand(StageNodeSPtr& next_node, TranspositionTable<StageNode>* transposition_table = nullptr);
+        void update_statistics(const HeuristicValue& heuristic_value);
         void update_statistics(const StageNodeSPtr& changed_child_node);
+        void add_pending_visit(const JointAction& joint_action);
+        void update_pending_statistics(const StageNodeSPtr& changed_child_node);
+        bool is_evaluation_pending() const {return evaluation_pending_;}
+        void set_evaluation_pending(const bool& evaluation_pending) {evaluation_pending_ = evaluation_pending;}
+        const JointAction& get_joint_action() const {return joint_action_;}
+        unsigned int get_id() const {return id_;}
+        unsigned int get_depth() const {return depth_;}
         bool each_agents_actions_expanded();
         bool each_joint_action_expanded();
         StageNodeSPtr get_shared();
         const S* get_state() const {return state_.get();}
         StageNodeWPtr get_parent() {return parent_;}
+        StageNodeSPtr get_child(const JointAction& joint_action) const;
         bool is_root() const {return !parent_.lock();}
         ActionIdx get_best_action();
 
@@ -95,6 +113,11 @@ struct container_hash {
         double getActionValue(int action);
 
         static void reset_counter();
+        static unsigned int get_num_nodes() {return num_nodes_;}
+
+        // Applies the function to the intermediate nodes of the other agents in this subtree, once per node
+        template<class Function>
+        void visit_other_int_nodes(const Function& function);
 
         MCTS_TEST
     };
@@ -120,7 +143,7 @@ struct container_hash {
         // Initialize the intermediate nodes of other agents
         InterNodeVector vec;
         // vec.resize(state_.get_num_agents()-1);
-        for (auto agent_idx : state_->get_other_agent_idx()) {
+        for (auto agent_idx : state_->get_other_agent_idx_range()) {
             vec.emplace_back(*state_, agent_idx, state_->get_num_actions(agent_idx), mcts_parameters);
         }
         return vec;
@@ -128,12 +151,13 @@ struct container_hash {
     joint_action_(joint_action),
     max_num_joint_actions_([this]()-> unsigned int{
         ActionIdx num_actions(state_->get_num_actions(state_->get_ego_agent_idx()));
-        for(auto agent_idx  : state_->get_other_agent_idx()) {
+        for(auto agent_idx  : state_->get_other_agent_idx_range()) {
             num_actions *=state_->get_num_actions(agent_idx);
         }
         return num_actions; }() ),
     id_(++num_nodes_),
     depth_(depth),
+    evaluation_pending_(false),
     mcts_parameters_(mcts_parameters)
     {
     }
@@ -148,16 +172,19 @@ struct container_hash {
     }
 
     template<class S, class SE, class SO, class H>
-    bool StageNode<S,SE, SO, H>::select_or_expand(StageNodeSPtr& next_node) {
-        // helper function to fill rewards and costs
-        auto fill_rewards = [this](const std::vector<Reward>& reward_list, const Cost& ego_cost, const JointAction& ja) {
-            ego_int_node_.collect(reward_list[S::ego_agent_idx], ego_cost, ja[S::ego_agent_idx]);
-            for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
-            {
-                other_int_nodes_[ai-1].collect(reward_list[ai], ego_cost, ja[ai] );
-            }
-        };
+    void StageNode<S,SE, SO, H>::collect_rewards(const JointAction& joint_action) {
+        // fill intermediate nodes with the remembered rewards and costs of the joint action
+        const std::vector<Reward>& reward_list = joint_rewards_.at(joint_action);
+        const Cost& ego_cost = ego_costs_.at(joint_action);
+        ego_int_node_.collect(reward_list[S::ego_agent_idx], ego_cost, joint_action[S::ego_agent_idx]);
+        for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
+        {
+            other_int_nodes_[ai-1].collect(reward_list[ai], ego_cost, joint_action[ai] );
+        }
+    }
 
+    template<class S, class SE, class SO, class H>
+    bool StageNode<S,SE, SO, H>::select_or_expand(StageNodeSPtr& next_node, TranspositionTable<StageNode>* transposition_table) {
         // First check if state of node is terminal
         if(this->get_state()->is_terminal()) {
             next_node = get_shared();
@@ -178,28 +205,44 @@ struct container_hash {
         {
             // SELECT EXISTING NODE
             next_node = it->second;
-            fill_rewards(joint_rewards_[joint_action], ego_costs_[joint_action], joint_action);
+            collect_rewards(joint_action);
             return true;
         }
         else
         {   // EXPAND NEW NODE BASED ON NEW JOINT ACTION
             std::vector<Reward> rewards;
             Cost ego_cost;
+            std::shared_ptr<S> next_state = state_->execute(joint_action, rewards, ego_cost);
+            StageNodeSPtr transposition = transposition_table ? transposition_table->find(*next_state, depth_+1) : nullptr;
+            if(transposition)
+            {
+                // LINK EXISTING NODE OF AN EQUAL STATE, selection continues there
+                next_node = transposition;
+                children_[joint_action] = next_node;
+                joint_rewards_[joint_action] = rewards;
+                ego_costs_[joint_action] = ego_cost;
+                collect_rewards(joint_action);
+                return true;
+            }
             next_node = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>,
                     const JointAction&, const unsigned int&> 
                     (get_shared(),
-                    state_->execute(joint_action, rewards, ego_cost),
+                    std::move(next_state),
                     joint_action,
                     depth_+1,
                     mcts_parameters_);
             children_[joint_action] = next_node;
+            if(transposition_table)
+            {
+                transposition_table->insert(next_node);
+            }
             #ifdef PLAN_DEBUG_INFO
             //     std::cout << "expanded node state: " << state_->execute(joint_action, rewards)->sprintf();
             #endif
             // collect intermediate rewards and selected action indexes
-            fill_rewards(rewards, ego_cost, joint_action);
             joint_rewards_[joint_action] = rewards;
             ego_costs_[joint_action] = ego_cost;
+            collect_rewards(joint_action);
 
             return false;
         }
@@ -209,6 +252,34 @@ struct container_hash {
     template<class S, class SE, class SO, class H>
     unsigned int StageNode<S,SE, SO, H>::num_nodes_ = 0;
 
+    template<class S, class SE, class SO, class H>
+    typename StageNode<S,SE, SO, H>::StageNodeSPtr StageNode<S,SE, SO, H>::get_child(const JointAction& joint_action) const {
+        const auto it = children_.find(joint_action);
+        return it != children_.end() ? it->second : nullptr;
+    }
+
+    template<class S, class SE, class SO, class H>
+    template<class Function>
+    void StageNode<S,SE, SO, H>::visit_other_int_nodes(const Function& function) {
+        std::unordered_set<const StageNode*> visited;
+        visit_other_int_nodes(function, visited);
+    }
+
+    template<class S, class SE, class SO, class H>
+    template<class Function>
+    void StageNode<S,SE, SO, H>::visit_other_int_nodes(const Function& function, std::unordered_set<const StageNode*>& visited) {
+        // Nodes linked by a transposition table are reachable from several parents
+        if (!visited.insert(this).second) {
+            return;
+        }
+        for (auto& other_int_node : other_int_nodes_) {
+            function(other_int_node);
+        }
+        for (auto& child : children_) {
+            child.second->visit_other_int_nodes(function, visited);
+        }
+    }
+
     template<class S, class SE, class SO, class H>
     void StageNode<S,SE, SO, H>::reset_counter() {
         StageNode<S,SE, SO, H>::num_nodes_ = 0;
@@ -221,12 +292,12 @@ struct container_hash {
     }
 
     template<class S, class SE, class SO, class H>
-    void StageNode<S,SE, SO, H>::update_statistics(const SE& ego_heuristic_estimate, const std::unordered_map<AgentIdx, SO>& other_heuristic_estimates)
+    void StageNode<S,SE, SO, H>::update_statistics(const HeuristicValue& heuristic_value)
     {
-        ego_int_node_.update_from_heuristic(ego_heuristic_estimate);
-        for (auto it = other_int_nodes_.begin(); it != other_int_nodes_.end(); ++it)
+        ego_int_node_.update_from_heuristic(heuristic_value.returns[S::ego_agent_idx], heuristic_value.ego_cost);
+        for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
         {
-            it->update_from_heuristic(other_heuristic_estimates.at(it->get_agent_idx()));
+            other_int_nodes_[ai-1].update_from_heuristic(heuristic_value.returns[ai], heuristic_value.ego_cost);
         }
     }
 
@@ -239,6 +310,29 @@ struct container_hash {
         }
     }
 
+    template<class S, class SE, class SO, class H>
+    void StageNode<S,SE, SO, H>::add_pending_visit(const JointAction& joint_action) {
+        ego_int_node_.add_pending_visit(joint_action[S::ego_agent_idx]);
+        for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
+        {
+            other_int_nodes_[ai-1].add_pending_visit(joint_action[ai]);
+        }
+    }
+
+    template<class S, class SE, class SO, class H>
+    void StageNode<S,SE, SO, H>::update_pending_statistics(const StageNodeSPtr &changed_child_node) {
+        // Other iterations may have passed this node since the child was selected,
+        // collect the rewards of the child's joint action again before updating
+        const JointAction& joint_action = changed_child_node->joint_action_;
+        ego_int_node_.remove_pending_visit(joint_action[S::ego_agent_idx]);
+        for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
+        {
+            other_int_nodes_[ai-1].remove_pending_visit(joint_action[ai]);
+        }
+        collect_rewards(joint_action);
+        update_statistics(changed_child_node);
+    }
+
     template<class S, class SE, class SO, class H>
     ActionIdx StageNode<S,SE, SO, H>::get_best_action(){
         ActionIdx best = ego_int_node_.get_best_action();
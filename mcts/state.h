@@ -12,6 +12,8 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
 #include "common.h"
 
 
@@ -25,6 +27,55 @@ typedef std::vector<ActionIdx> JointAction;
 typedef double Reward;
 typedef double Cost;
 
+/*
+ * Non-owning range of agent indices returned by states without allocating. It either counts up
+ * contiguous indices [first, last) or views indices stored by the state, which must outlive the range.
+ */
+class AgentIdxRange {
+  public:
+    class const_iterator {
+      public:
+        // Contiguous indices are computed and returned by value, which only an input iterator allows
+        typedef std::input_iterator_tag iterator_category;
+        typedef AgentIdx value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef AgentIdx reference;
+
+        const_iterator(const AgentIdx* indices, const std::size_t& position) : indices_(indices), position_(position) {}
+
+        AgentIdx operator*() const { return indices_ ? indices_[position_] : static_cast<AgentIdx>(position_); }
+        const_iterator& operator++() { ++position_; return *this; }
+        const_iterator operator++(int) { const_iterator it(*this); ++position_; return it; }
+        bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+      private:
+        const AgentIdx* indices_; // nullptr for contiguous indices, the position is then the index itself
+        std::size_t position_;
+    };
+
+    AgentIdxRange(const AgentIdx& first, const AgentIdx& last) : indices_(nullptr), first_(first), last_(last) {}
+
+    explicit AgentIdxRange(const std::vector<AgentIdx>& indices) : indices_(indices.data()), first_(0), last_(indices.size()) {}
+
+    const_iterator begin() const { return const_iterator(indices_, first_); }
+    const_iterator end() const { return const_iterator(indices_, last_); }
+
+    AgentIdx operator[](const std::size_t& idx) const { return indices_ ? indices_[idx] : first_ + idx; }
+
+    std::size_t size() const { return last_ - first_; }
+
+    bool empty() const { return last_ == first_; }
+
+    bool is_contiguous() const { return !indices_; }
+
+  private:
+    const AgentIdx* indices_;
+    AgentIdx first_;
+    AgentIdx last_;
+};
+
     template <typename T>
 inline std::vector<T> operator+(const std::vector<T>& a, const std::vector<T>& b)
     {
@@ -71,8 +122,11 @@ public:
 
     bool is_terminal() const;
 
+    // Allocates, search code uses the range returned by get_other_agent_idx_range()
     const std::vector<AgentIdx> get_other_agent_idx() const;
 
+    AgentIdxRange get_other_agent_idx_range() const;
+
     const AgentIdx get_ego_agent_idx() const;
 
     const AgentIdx get_num_agents() const;
@@ -81,6 +135,11 @@ public:
 
     std::string sprintf() const;
 
+    // Only available for states deriving from SupportsHashing, see is_hashable_state
+    std::size_t hash() const;
+
+    bool equals(const Implementation& other) const;
+
     ~StateInterface() {};
 
     static const Implementation& cast();
@@ -115,7 +174,16 @@ inline bool StateInterface<Implementation>::is_terminal() const {
 
 template<typename Implementation>
 inline const std::vector<AgentIdx> StateInterface<Implementation>::get_other_agent_idx() const {
-    return impl().get_other_agent_idx();
+    const AgentIdxRange agent_idx = impl().get_other_agent_idx_range();
+    std::vector<AgentIdx> other_agent_idx;
+    other_agent_idx.reserve(agent_idx.size());
+    other_agent_idx.assign(agent_idx.begin(), agent_idx.end());
+    return other_agent_idx;
+}
+
+template<typename Implementation>
+inline AgentIdxRange StateInterface<Implementation>::get_other_agent_idx_range() const {
+    return impl().get_other_agent_idx_range();
 }
 
 template<typename Implementation>
@@ -125,7 +193,7 @@ inline const AgentIdx StateInterface<Implementation>::get_ego_agent_idx() const
 
 template<typename Implementation>
 inline const AgentIdx StateInterface<Implementation>::get_num_agents() const {
-    return impl().get_other_agent_idx().size() + 1; // num other agents + ego agent
+    return impl().get_other_agent_idx_range().size() + 1; // num other agents + ego agent
 }
 
 
@@ -134,6 +202,20 @@ inline std::string StateInterface<Implementation>::sprintf() const {
     return impl().sprintf();
 }
 
+template<typename Implementation>
+inline std::size_t StateInterface<Implementation>::hash() const {
+    return impl().hash();
+}
+
+template<typename Implementation>
+inline bool StateInterface<Implementation>::equals(const Implementation& other) const {
+    return impl().equals(other);
+}
+
+// Detects states identifiable by hash() and equals(), e.g. for transposition tables
+template<typename S>
+using is_hashable_state = std::is_base_of<SupportsHashing, S>;
+
 
 template<typename Implementation>
 const AgentIdx StateInterface<Implementation>::ego_agent_idx = 0;
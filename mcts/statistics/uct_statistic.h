@@ -30,6 +30,7 @@ public:
              return map;
              }()),
              total_node_visits_(0),
+             total_pending_visits_(0),
              unexpanded_actions_(num_actions),
              upper_bound(mcts_parameters.uct_statistic.UPPER_BOUND),
              lower_bound(mcts_parameters.uct_statistic.LOWER_BOUND),
@@ -76,10 +77,9 @@ public:
         return best;
     }
 
-    void update_from_heuristic(const NodeStatistic<UctStatistic>& heuristic_statistic)
+    void update_from_heuristic(const Reward& heuristic_return, const Cost&)
     {
-        const UctStatistic& heuristic_statistic_impl = heuristic_statistic.impl();
-        value_ = heuristic_statistic_impl.value_;
+        value_ = heuristic_return;
         latest_return_ = value_;
         total_node_visits_ += 1;
     }
@@ -98,9 +98,14 @@ public:
         value_ = value_ + (latest_return_ - value_) / total_node_visits_;
     }
 
-    void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost)
-    {
-       value_ = accum_rewards;
+    void add_pending_visit(const ActionIdx& action_idx) {
+        ucb_statistics_[action_idx].pending_count_ += 1;
+        total_pending_visits_ += 1;
+    }
+
+    void remove_pending_visit(const ActionIdx& action_idx) {
+        ucb_statistics_[action_idx].pending_count_ -= 1;
+        total_pending_visits_ -= 1;
     }
 
     std::string print_node_information() const
@@ -123,21 +128,29 @@ public:
 
     typedef struct UcbPair
     {
-        UcbPair() : action_count_(0), action_value_(0.0f) {};
+        UcbPair() : action_count_(0), action_value_(0.0f), pending_count_(0) {};
         unsigned action_count_;
         double action_value_;
+        unsigned pending_count_; // iterations through this action with leaf evaluation in flight
     } UcbPair;
 
     void calculate_ucb_values(const std::map<ActionIdx, UcbPair>& ucb_statistics, std::vector<double>& values ) const
     {
         values.resize(ucb_statistics.size());
+        const unsigned int node_visits = total_node_visits_ + total_pending_visits_;
 
         for (size_t idx = 0; idx < ucb_statistics.size(); ++idx)
         {
-            double action_value_normalized = (ucb_statistics.at(idx).action_value_-lower_bound)/(upper_bound-lower_bound); 
+            const UcbPair& ucb_pair = ucb_statistics.at(idx);
+            double action_value_normalized = (ucb_pair.action_value_-lower_bound)/(upper_bound-lower_bound); 
             MCTS_EXPECT_TRUE(action_value_normalized>=0);
             MCTS_EXPECT_TRUE(action_value_normalized<=1);
-            values[idx] = action_value_normalized + 2 * k_exploration_constant * sqrt( (2* log(total_node_visits_)) / ( ucb_statistics.at(idx).action_count_)  );
+            const unsigned int action_visits = ucb_pair.action_count_ + ucb_pair.pending_count_;
+            if(ucb_pair.pending_count_ > 0) {
+                // Virtual loss: pending visits count as returns at the lower bound to spread in-flight iterations
+                action_value_normalized *= double(ucb_pair.action_count_)/action_visits;
+            }
+            values[idx] = action_value_normalized + 2 * k_exploration_constant * sqrt( (2* log(node_visits)) / ( action_visits)  );
         }
     }
 private:
@@ -146,6 +159,7 @@ private:
     double latest_return_;   // tracks the return during backpropagation
     std::map<ActionIdx, UcbPair> ucb_statistics_; // first: action selection count, action-value
     unsigned int total_node_visits_;
+    unsigned int total_pending_visits_;
     std::vector<int> unexpanded_actions_; // contains all action indexes which have not been expanded yet
 
     // PARAMS
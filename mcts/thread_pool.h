@@ -0,0 +1,119 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_THREAD_POOL_H
+#define MCTS_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcts {
+
+// Fixed number of worker threads processing tasks in submission order. Each task receives the index
+// of the executing worker, such that tasks can use per worker resources without locking.
+class ThreadPool
+{
+public:
+    using Task = std::function<void(const unsigned int& worker_idx)>;
+
+    ThreadPool(const unsigned int& num_threads) : tasks_(), mutex_(), task_available_(), stop_(false), workers_() {
+        for (unsigned int worker_idx = 0; worker_idx < num_threads; ++worker_idx) {
+            workers_.emplace_back([this, worker_idx]() { run(worker_idx); });
+        }
+    }
+
+    // Remaining tasks are processed before the workers are joined
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        task_available_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Submitted tasks must not throw, they catch and hand over their exceptions themselves
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        task_available_.notify_one();
+    }
+
+    // Calls function(task_idx) for all tasks on the workers and blocks until all are done.
+    // The first exception thrown by a task is rethrown in the calling thread.
+    template<class Function>
+    void parallel_for(const std::size_t& num_tasks, const Function& function);
+
+    unsigned int size() const { return workers_.size(); }
+
+private:
+    void run(const unsigned int worker_idx) {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                task_available_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task(worker_idx);
+        }
+    }
+
+    std::deque<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    bool stop_;
+    std::vector<std::thread> workers_; // last member, threads must start after and stop before the other members
+};
+
+template<class Function>
+inline void ThreadPool::parallel_for(const std::size_t& num_tasks, const Function& function) {
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::size_t num_done = 0;
+    std::exception_ptr exception;
+    for (std::size_t task_idx = 0; task_idx < num_tasks; ++task_idx) {
+        submit([&, task_idx](const unsigned int&) {
+            std::exception_ptr task_exception;
+            try {
+                function(task_idx);
+            } catch (...) {
+                task_exception = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (task_exception && !exception) {
+                exception = task_exception;
+            }
+            num_done += 1;
+            done.notify_one();
+        });
+    }
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&]() { return num_done == num_tasks; });
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+} // namespace mcts
+
+#endif // MCTS_THREAD_POOL_H
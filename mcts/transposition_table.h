@@ -0,0 +1,86 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_TRANSPOSITION_TABLE_H
+#define MCTS_TRANSPOSITION_TABLE_H
+
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <boost/functional/hash.hpp>
+#include "mcts/state.h"
+
+namespace mcts {
+
+/*
+ * Nodes of a search keyed by their depth and state, such that equal states reached by different joint
+ * actions share one node. Keys include the depth, the search graph thus remains acyclic also for states
+ * reached again by later steps. Nodes are owned by their parents, the table only holds weak references.
+ * States without hashing support are never found.
+ */
+template<class Node>
+class TranspositionTable {
+  public:
+    using NodeSPtr = std::shared_ptr<Node>;
+
+    TranspositionTable() : nodes_() {}
+
+    template<class S>
+    NodeSPtr find(const S& state, const unsigned int& depth) {
+      return find(state, depth, is_hashable_state<S>());
+    }
+
+    void insert(const NodeSPtr& node) {
+      insert(node, is_hashable_state<typename std::remove_cv<
+                            typename std::remove_pointer<decltype(node->get_state())>::type>::type>());
+    }
+
+    void clear() { nodes_.clear(); }
+
+    std::size_t size() const { return nodes_.size(); }
+
+  private:
+    static std::size_t key(const std::size_t& state_hash, const unsigned int& depth) {
+      std::size_t seed = state_hash;
+      boost::hash_combine(seed, depth);
+      return seed;
+    }
+
+    template<class S>
+    NodeSPtr find(const S& state, const unsigned int& depth, std::true_type) {
+      const auto range = nodes_.equal_range(key(state.hash(), depth));
+      for (auto it = range.first; it != range.second;) {
+        const NodeSPtr node = it->second.lock();
+        if (!node) {
+          // Released with a discarded subtree
+          it = nodes_.erase(it);
+          continue;
+        }
+        if (node->get_depth() == depth && node->get_state()->equals(state)) {
+          return node;
+        }
+        ++it;
+      }
+      return nullptr;
+    }
+
+    template<class S>
+    NodeSPtr find(const S&, const unsigned int&, std::false_type) {
+      return nullptr;
+    }
+
+    void insert(const NodeSPtr& node, std::true_type) {
+      nodes_.emplace(key(node->get_state()->hash(), node->get_depth()), node);
+    }
+
+    void insert(const NodeSPtr&, std::false_type) {}
+
+    std::unordered_multimap<std::size_t, std::weak_ptr<Node>> nodes_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_TRANSPOSITION_TABLE_H
@@ -0,0 +1,52 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_VALUE_ESTIMATOR_H
+#define MCTS_VALUE_ESTIMATOR_H
+
+#include <vector>
+#include "state.h"
+#include "mcts_parameters.h"
+
+namespace mcts {
+
+/*
+ * Estimates the remaining return of a non-terminal state. Heuristics use it
+ * to bootstrap the tail of rollouts which were truncated before reaching a terminal state.
+ * Values are indexed in the same order as the joint action (ego agent first).
+ */
+template <class Implementation>
+class ValueEstimator
+{
+public:
+    ValueEstimator(const MctsParameters &mcts_parameters) : mcts_parameters_(mcts_parameters) {}
+
+    template<class S>
+    void estimate_value(const S& state, std::vector<Reward>& values, Cost& ego_cost) const;
+
+private:
+    const Implementation& impl() const;
+
+protected:
+    const MctsParameters& mcts_parameters_;
+};
+
+
+template <class Implementation>
+inline const Implementation& ValueEstimator<Implementation>::impl() const {
+    return *static_cast<const Implementation*>(this);
+}
+
+template <class Implementation>
+template<class S>
+inline void ValueEstimator<Implementation>::estimate_value(const S& state, std::vector<Reward>& values, Cost& ego_cost) const
+{
+    return impl().estimate_value(state, values, ego_cost);
+}
+
+} // namespace mcts
+
+#endif
@@ -0,0 +1,30 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef ZERO_VALUE_ESTIMATOR_H
+#define ZERO_VALUE_ESTIMATOR_H
+
+#include "mcts/value_estimator.h"
+
+namespace mcts {
+
+// Assumes no return beyond the rollout horizon, a truncated rollout then equals a rollout stopped at the horizon
+class ZeroValueEstimator : public mcts::ValueEstimator<ZeroValueEstimator>
+{
+public:
+    ZeroValueEstimator(const MctsParameters& mcts_parameters) :
+            mcts::ValueEstimator<ZeroValueEstimator>(mcts_parameters) {}
+
+    template<class S>
+    void estimate_value(const S& state, std::vector<Reward>& values, Cost& ego_cost) const {
+        values.assign(state.get_num_agents(), 0.0f);
+        ego_cost = 0.0f;
+    }
+};
+
+} // namespace mcts
+
+#endif
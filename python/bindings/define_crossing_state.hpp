@@ -10,6 +10,7 @@
 #include "python/bindings/common.hpp"
 #include "environments/crossing_state.h"
 #include "environments/crossing_state_episode_runner.h"
+#include "python/bindings/python_value_heuristic.hpp"
 
 namespace py = pybind11;
 using namespace mcts;
@@ -103,7 +104,8 @@ void define_crossing_state(py::module m, std::string suffix) {
     std::string name4 = "CrossingState" + suffix;
     py::class_<CrossingState<Domain>,
              std::shared_ptr<CrossingState<Domain>>>(m, name4.c_str())
-      .def(py::init<const std::unordered_map<AgentIdx, HypothesisId>&, const CrossingStateParameters<Domain>&>())
+      .def(py::init<const HypothesisContext&, const CrossingStateParameters<Domain>&>(),
+           py::keep_alive<1, 2>()) // the state refers to the hypothesis context
       .def("__repr__", [](const CrossingState<Domain> &m) {
         return typeid(m).name();
       })
@@ -129,8 +131,66 @@ void define_crossing_state(py::module m, std::string suffix) {
       .def("step", &CrossingStateEpisodeRunner<Domain>::step)
       .def("run", &CrossingStateEpisodeRunner<Domain>::run);
 
+    // Leaves are evaluated by a Python value function, the GIL is released during search
+    using PyValueEpisodeRunner = CrossingStateEpisodeRunner<Domain, PyBatchValueHeuristic>;
+    std::string name7 = "CrossingStateEpisodeRunnerPyValue" + suffix;
+    py::class_<PyValueEpisodeRunner,
+             std::shared_ptr<PyValueEpisodeRunner>>(m, name7.c_str())
+      .def(py::init<const std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>>&,
+                            const std::vector<AgentPolicyCrossingState<Domain>>&,
+                            const mcts::MctsParameters&,
+                            const CrossingStateParameters<Domain>&,
+                            const unsigned int&,
+                            const unsigned int&,
+                            const unsigned int&,
+                            mcts::Viewer*,
+                            const py::function&>())
+      .def("__repr__", [](const PyValueEpisodeRunner &m) {
+        return typeid(m).name();
+      })
+      .def("step", &PyValueEpisodeRunner::step, py::call_guard<py::gil_scoped_release>())
+      .def("run", &PyValueEpisodeRunner::run, py::call_guard<py::gil_scoped_release>());
+
     std::string name6 = "CrossingStateDefaultParameters" + suffix;
     m.def(name6.c_str(), &default_crossing_state_parameters<Domain>);
 }
 
+// Crossing state with a number of other agents fixed at compile time, e.g. CrossingStateInt2,
+// parameters and policies are shared with the variant defined by define_crossing_state
+template <typename Domain, std::size_t NumOtherAgents>
+void define_crossing_state_fixed_num_agents(py::module m, std::string suffix) {
+    suffix += std::to_string(NumOtherAgents);
+    using FixedCrossingState = CrossingState<Domain, NumOtherAgents>;
+    std::string name1 = "CrossingState" + suffix;
+    py::class_<FixedCrossingState,
+             std::shared_ptr<FixedCrossingState>>(m, name1.c_str())
+      .def(py::init<const HypothesisContext&, const CrossingStateParameters<Domain>&>(),
+           py::keep_alive<1, 2>()) // the state refers to the hypothesis context
+      .def("__repr__", [](const FixedCrossingState &m) {
+        return typeid(m).name();
+      })
+      .def("draw", &FixedCrossingState::draw)
+      .def_property_readonly("other_agents_states", &FixedCrossingState::get_agent_states)
+      .def_property_readonly("ego_agent_state", &FixedCrossingState::get_ego_state)
+      .def("add_hypothesis", &FixedCrossingState::add_hypothesis);
+
+    using FixedEpisodeRunner = CrossingStateEpisodeRunner<Domain, RandomHeuristic, NumOtherAgents>;
+    std::string name2 = "CrossingStateEpisodeRunner" + suffix;
+    py::class_<FixedEpisodeRunner,
+             std::shared_ptr<FixedEpisodeRunner>>(m, name2.c_str())
+      .def(py::init<const std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>>&,
+                            const std::vector<AgentPolicyCrossingState<Domain>>&,
+                            const mcts::MctsParameters&,
+                            const CrossingStateParameters<Domain>&,
+                            const unsigned int&,
+                            const unsigned int&,
+                            const unsigned int&,
+                            mcts::Viewer*>())
+      .def("__repr__", [](const FixedEpisodeRunner &m) {
+        return typeid(m).name();
+      })
+      .def("step", &FixedEpisodeRunner::step)
+      .def("run", &FixedEpisodeRunner::run);
+}
+
 #endif // PYTHON_DEFINE_CROSSING_STATE_HPP_
\ No newline at end of file
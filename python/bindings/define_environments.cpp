@@ -22,4 +22,12 @@ void define_environments(py::module m)
 
     define_crossing_state<int>(m, "Int");
     define_crossing_state<float>(m, "Float");
+
+    // Common numbers of other agents
+    define_crossing_state_fixed_num_agents<int, 1>(m, "Int");
+    define_crossing_state_fixed_num_agents<int, 2>(m, "Int");
+    define_crossing_state_fixed_num_agents<int, 4>(m, "Int");
+    define_crossing_state_fixed_num_agents<float, 1>(m, "Float");
+    define_crossing_state_fixed_num_agents<float, 2>(m, "Float");
+    define_crossing_state_fixed_num_agents<float, 4>(m, "Float");
 }
\ No newline at end of file
@@ -27,10 +27,13 @@ void define_mamcts(py::module m)
       .def_readwrite("DISCOUNT_FACTOR", &MctsParameters::DISCOUNT_FACTOR)
       .def_readwrite("MAX_SEARCH_TIME", &MctsParameters::MAX_SEARCH_TIME)
       .def_readwrite("MAX_NUMBER_OF_ITERATIONS", &MctsParameters::MAX_NUMBER_OF_ITERATIONS)
+      .def_readwrite("REUSE_TREE_ITERATIONS", &MctsParameters::REUSE_TREE_ITERATIONS)
+      .def_readwrite("TRANSPOSITION_TABLE", &MctsParameters::TRANSPOSITION_TABLE)
       .def_readwrite("hypothesis_statistic", &MctsParameters::hypothesis_statistic)
       .def_readwrite("uct_statistic", &MctsParameters::uct_statistic)
       .def_readwrite("random_heuristic", &MctsParameters::random_heuristic)
       .def_readwrite("hypothesis_belief_tracker", &MctsParameters::hypothesis_belief_tracker)
+      .def_readwrite("leaf_evaluation_pipeline", &MctsParameters::leaf_evaluation_pipeline)
       .def(py::pickle(
         [](const MctsParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
@@ -39,14 +42,17 @@ void define_mamcts(py::module m)
             d["DISCOUNT_FACTOR"] = p.DISCOUNT_FACTOR;
             d["MAX_SEARCH_TIME"] = p.MAX_SEARCH_TIME;
             d["MAX_NUMBER_OF_ITERATIONS"] = p.MAX_NUMBER_OF_ITERATIONS;
+            d["REUSE_TREE_ITERATIONS"] = p.REUSE_TREE_ITERATIONS;
+            d["TRANSPOSITION_TABLE"] = p.TRANSPOSITION_TABLE;
             d["hypothesis_statistic"] = p.hypothesis_statistic;
             d["uct_statistic"] = p.uct_statistic;
             d["random_heuristic"] = p.random_heuristic;
             d["hypothesis_belief_tracker"] = p.hypothesis_belief_tracker;
+            d["leaf_evaluation_pipeline"] = p.leaf_evaluation_pipeline;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 8)
+            if (d.size() != 11)
                 throw std::runtime_error("Invalid MctsParameters state!");
 
             /* Create a new C++ instance */
@@ -55,10 +61,13 @@ void define_mamcts(py::module m)
             p.DISCOUNT_FACTOR = d["DISCOUNT_FACTOR"].cast<double>();
             p.MAX_SEARCH_TIME = d["MAX_SEARCH_TIME"].cast<unsigned int>();
             p.MAX_NUMBER_OF_ITERATIONS = d["MAX_NUMBER_OF_ITERATIONS"].cast<double>();
+            p.REUSE_TREE_ITERATIONS = d["REUSE_TREE_ITERATIONS"].cast<unsigned int>();
+            p.TRANSPOSITION_TABLE = d["TRANSPOSITION_TABLE"].cast<bool>();
             p.hypothesis_statistic = d["hypothesis_statistic"].cast<MctsParameters::HypothesisStatisticParameters>();
             p.uct_statistic = d["uct_statistic"].cast<MctsParameters::UctStatisticParameters>();
             p.random_heuristic = d["random_heuristic"].cast<MctsParameters::RandomHeuristicParameters>();
             p.hypothesis_belief_tracker = d["hypothesis_belief_tracker"].cast<MctsParameters::HypothesisBeliefTrackerParameters>();
+            p.leaf_evaluation_pipeline = d["leaf_evaluation_pipeline"].cast<MctsParameters::LeafEvaluationPipelineParameters>();
             return p;
         }
     ));
@@ -71,22 +80,42 @@ void define_mamcts(py::module m)
       .def_readwrite("MAX_SEARCH_TIME", &MctsParameters::RandomHeuristicParameters::MAX_SEARCH_TIME)
       .def_readwrite("MAX_NUMBER_OF_ITERATIONS",
                &MctsParameters::RandomHeuristicParameters::MAX_NUMBER_OF_ITERATIONS)
+      .def_readwrite("ROLLOUT_HORIZON",
+               &MctsParameters::RandomHeuristicParameters::ROLLOUT_HORIZON)
+      .def_readwrite("COMMON_RANDOM_NUMBERS",
+               &MctsParameters::RandomHeuristicParameters::COMMON_RANDOM_NUMBERS)
+      .def_readwrite("MAX_NUMBER_OF_ROLLOUTS",
+               &MctsParameters::RandomHeuristicParameters::MAX_NUMBER_OF_ROLLOUTS)
+      .def_readwrite("ROLLOUT_STANDARD_ERROR_THRESHOLD",
+               &MctsParameters::RandomHeuristicParameters::ROLLOUT_STANDARD_ERROR_THRESHOLD)
+      .def_readwrite("MAX_LEAF_EVALUATION_TIME",
+               &MctsParameters::RandomHeuristicParameters::MAX_LEAF_EVALUATION_TIME)
       .def(py::pickle(
         [](const MctsParameters::RandomHeuristicParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
             py::dict d;
             d["MAX_SEARCH_TIME"] = p.MAX_SEARCH_TIME;
             d["MAX_NUMBER_OF_ITERATIONS"] = p.MAX_NUMBER_OF_ITERATIONS;
+            d["ROLLOUT_HORIZON"] = p.ROLLOUT_HORIZON;
+            d["COMMON_RANDOM_NUMBERS"] = p.COMMON_RANDOM_NUMBERS;
+            d["MAX_NUMBER_OF_ROLLOUTS"] = p.MAX_NUMBER_OF_ROLLOUTS;
+            d["ROLLOUT_STANDARD_ERROR_THRESHOLD"] = p.ROLLOUT_STANDARD_ERROR_THRESHOLD;
+            d["MAX_LEAF_EVALUATION_TIME"] = p.MAX_LEAF_EVALUATION_TIME;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 2)
+            if (d.size() != 7)
                 throw std::runtime_error("Invalid RandomHeuristicParameters state!");
 
             /* Create a new C++ instance */
             MctsParameters::RandomHeuristicParameters p;
             p.MAX_SEARCH_TIME = d["MAX_SEARCH_TIME"].cast<double>();
             p.MAX_NUMBER_OF_ITERATIONS = d["MAX_NUMBER_OF_ITERATIONS"].cast<unsigned int>();
+            p.ROLLOUT_HORIZON = d["ROLLOUT_HORIZON"].cast<unsigned int>();
+            p.COMMON_RANDOM_NUMBERS = d["COMMON_RANDOM_NUMBERS"].cast<bool>();
+            p.MAX_NUMBER_OF_ROLLOUTS = d["MAX_NUMBER_OF_ROLLOUTS"].cast<unsigned int>();
+            p.ROLLOUT_STANDARD_ERROR_THRESHOLD = d["ROLLOUT_STANDARD_ERROR_THRESHOLD"].cast<double>();
+            p.MAX_LEAF_EVALUATION_TIME = d["MAX_LEAF_EVALUATION_TIME"].cast<double>();
             return p;
         }
     ));
@@ -181,6 +210,9 @@ void define_mamcts(py::module m)
       .def_readwrite("PROBABILITY_DISCOUNT", &MctsParameters::HypothesisBeliefTrackerParameters::PROBABILITY_DISCOUNT)
       .def_readwrite("POSTERIOR_TYPE", &MctsParameters::HypothesisBeliefTrackerParameters::POSTERIOR_TYPE)
       .def_readwrite("FIXED_HYPOTHESIS_SET", &MctsParameters::HypothesisBeliefTrackerParameters::FIXED_HYPOTHESIS_SET)
+      .def_readwrite("STRATIFIED_HYPOTHESIS_SCHEDULE", &MctsParameters::HypothesisBeliefTrackerParameters::STRATIFIED_HYPOTHESIS_SCHEDULE)
+      .def_readwrite("NUM_BELIEF_UPDATE_THREADS", &MctsParameters::HypothesisBeliefTrackerParameters::NUM_BELIEF_UPDATE_THREADS)
+      .def_readwrite("BELIEF_PRUNING_THRESHOLD", &MctsParameters::HypothesisBeliefTrackerParameters::BELIEF_PRUNING_THRESHOLD)
       .def(py::pickle(
         [](const MctsParameters::HypothesisBeliefTrackerParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
@@ -190,10 +222,13 @@ void define_mamcts(py::module m)
             d["PROBABILITY_DISCOUNT"] = p.PROBABILITY_DISCOUNT;
             d["POSTERIOR_TYPE"] = p.POSTERIOR_TYPE;
             d["FIXED_HYPOTHESIS_SET"] = p.FIXED_HYPOTHESIS_SET;
+            d["STRATIFIED_HYPOTHESIS_SCHEDULE"] = p.STRATIFIED_HYPOTHESIS_SCHEDULE;
+            d["NUM_BELIEF_UPDATE_THREADS"] = p.NUM_BELIEF_UPDATE_THREADS;
+            d["BELIEF_PRUNING_THRESHOLD"] = p.BELIEF_PRUNING_THRESHOLD;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 5)
+            if (d.size() != 8)
                 throw std::runtime_error("Invalid HypothesisBeliefTrackerParameters state!");
 
             /* Create a new C++ instance */
@@ -204,6 +239,36 @@ void define_mamcts(py::module m)
             p.POSTERIOR_TYPE = d["POSTERIOR_TYPE"].cast<int>();
             p.FIXED_HYPOTHESIS_SET = d["FIXED_HYPOTHESIS_SET"].cast<
                         std::unordered_map<unsigned int, unsigned int>>();
+            p.STRATIFIED_HYPOTHESIS_SCHEDULE = d["STRATIFIED_HYPOTHESIS_SCHEDULE"].cast<bool>();
+            p.NUM_BELIEF_UPDATE_THREADS = d["NUM_BELIEF_UPDATE_THREADS"].cast<unsigned int>();
+            p.BELIEF_PRUNING_THRESHOLD = d["BELIEF_PRUNING_THRESHOLD"].cast<double>();
+            return p;
+        }
+    ));
+
+    py::class_<MctsParameters::LeafEvaluationPipelineParameters>(m ,"MctsParametersLeafEvaluationPipelineParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::LeafEvaluationPipelineParameters &m) {
+        return "mamcts.MctsParametersLeafEvaluationPipelineParameters";
+      })
+      .def_readwrite("NUM_EVALUATOR_THREADS", &MctsParameters::LeafEvaluationPipelineParameters::NUM_EVALUATOR_THREADS)
+      .def_readwrite("BATCH_SIZE", &MctsParameters::LeafEvaluationPipelineParameters::BATCH_SIZE)
+      .def(py::pickle(
+        [](const MctsParameters::LeafEvaluationPipelineParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["NUM_EVALUATOR_THREADS"] = p.NUM_EVALUATOR_THREADS;
+            d["BATCH_SIZE"] = p.BATCH_SIZE;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 2)
+                throw std::runtime_error("Invalid LeafEvaluationPipelineParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::LeafEvaluationPipelineParameters p;
+            p.NUM_EVALUATOR_THREADS = d["NUM_EVALUATOR_THREADS"].cast<unsigned int>();
+            p.BATCH_SIZE = d["BATCH_SIZE"].cast<unsigned int>();
             return p;
         }
     ));
@@ -216,6 +281,16 @@ void define_mamcts(py::module m)
         return "mamcts.MctsCrossingStateIntUctUct";
       });
 
+    py::class_<HypothesisContext,
+             std::shared_ptr<HypothesisContext>>(m, "HypothesisContext")
+      .def(py::init<>())
+      .def(py::init<const std::unordered_map<AgentIdx, HypothesisId>&>())
+      .def("__repr__", [](const HypothesisContext &m) {
+        return "mamcts.HypothesisContext";
+      })
+      .def("at", &HypothesisContext::at)
+      .def_property_readonly("agents", &HypothesisContext::agents);
+
     py::class_<HypothesisBeliefTracker> belief_tracker(m, "HypothesisBeliefTracker");
 
     py::enum_<HypothesisBeliefTracker::PosteriorType>(belief_tracker , "PosteriorType")
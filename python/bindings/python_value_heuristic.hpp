@@ -0,0 +1,117 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef PYTHON_PYTHON_VALUE_HEURISTIC_HPP_
+#define PYTHON_PYTHON_VALUE_HEURISTIC_HPP_
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "python/bindings/common.hpp"
+#include "pybind11/numpy.h"
+#include "mcts/heuristic.h"
+#include "environments/crossing_state.h"
+
+namespace py = pybind11;
+
+namespace mcts {
+
+// Features of a crossing state passed to value functions: position and last action of each agent, ego agent first
+template<typename Domain, std::size_t NumOtherAgents>
+inline std::size_t value_feature_size(const CrossingState<Domain, NumOtherAgents>& state) {
+    return 2*state.get_num_agents();
+}
+
+template<typename Domain, std::size_t NumOtherAgents>
+inline void value_features(const CrossingState<Domain, NumOtherAgents>& state, float* features) {
+    features[0] = static_cast<float>(state.get_ego_state().x_pos);
+    features[1] = static_cast<float>(state.get_ego_state().last_action);
+    std::size_t feature_idx = 2;
+    const auto& positions = state.get_agent_positions();
+    const auto& last_actions = state.get_agent_last_actions();
+    for (std::size_t agent = 0; agent < positions.size(); ++agent) {
+        features[feature_idx++] = static_cast<float>(positions[agent]);
+        features[feature_idx++] = static_cast<float>(last_actions[agent]);
+    }
+}
+
+/*
+ * Evaluates leaves with a Python callable, e.g. a neural value function. The callable receives the
+ * features of a whole batch of leaves as a float array of shape (B, F) and returns an array of shape
+ * (B, num_agents + 1) holding the returns of all agents, ordered as the joint action, and the ego cost
+ * in the last column. The GIL is only acquired once per batch, batches are formed by the leaf
+ * evaluation pipeline (see MctsParameters::LeafEvaluationPipelineParameters). The features do not
+ * depend on the sampled hypotheses, such that leaves of a hypothesis-based search are batched as well.
+ * A value function raising or returning a wrong shape fails the search, also on evaluator threads,
+ * and the error is raised by the step of the episode runner.
+ */
+class PyBatchValueHeuristic : public mcts::Heuristic<PyBatchValueHeuristic>, public mcts::IgnoresHypothesisContext
+{
+public:
+    PyBatchValueHeuristic(const MctsParameters& mcts_parameters, const py::function& value_function) :
+            mcts::Heuristic<PyBatchValueHeuristic>(mcts_parameters),
+            // Copies of the heuristic are made without holding the GIL, only the last one releases the callable
+            value_function_(new py::function(value_function), [](py::function* function) {
+                py::gil_scoped_acquire gil;
+                delete function;
+            }) {}
+
+    template<class S, class SE, class SO, class H>
+    HeuristicValue calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
+        std::vector<HeuristicValue> heuristic_values;
+        calculate_heuristic_values_batch(std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>>{node}, heuristic_values);
+        return heuristic_values.front();
+    }
+
+    template<class S, class SE, class SO, class H>
+    void calculate_heuristic_values_batch(const std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>> &nodes,
+                                          std::vector<HeuristicValue>& heuristic_values) {
+        heuristic_values.clear();
+        if (nodes.empty()) {
+            return;
+        }
+        const std::size_t batch_size = nodes.size();
+        const std::size_t num_features = value_feature_size(*nodes.front()->get_state());
+        const AgentIdx num_agents = nodes.front()->get_state()->get_num_agents();
+
+        // Gather the features without the GIL, Python is entered only for the conversion and the call
+        std::vector<float> features(batch_size*num_features);
+        for (std::size_t idx = 0; idx < batch_size; ++idx) {
+            value_features(*nodes[idx]->get_state(), features.data() + idx*num_features);
+        }
+
+        py::gil_scoped_acquire gil;
+        py::array_t<float> batch({batch_size, num_features});
+        std::copy(features.begin(), features.end(), batch.mutable_data());
+        const auto values = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure((*value_function_)(batch));
+        if (!values || values.ndim() != 2 || static_cast<std::size_t>(values.shape(0)) != batch_size ||
+                static_cast<std::size_t>(values.shape(1)) != num_agents + 1u) {
+            throw std::runtime_error("Value function must return an array of shape (batch size, number of agents + 1)");
+        }
+
+        const auto values_view = values.unchecked<2>();
+        heuristic_values.reserve(batch_size);
+        for (std::size_t idx = 0; idx < batch_size; ++idx) {
+            HeuristicValue heuristic_value(num_agents);
+            for (AgentIdx ai = 0; ai < num_agents; ++ai) {
+                heuristic_value.returns[ai] = values_view(idx, ai);
+            }
+            heuristic_value.ego_cost = values_view(idx, num_agents);
+            heuristic_values.push_back(std::move(heuristic_value));
+        }
+    }
+
+    std::string sprintf() const {
+        return "PyBatchValueHeuristic";
+    }
+
+private:
+    std::shared_ptr<py::function> value_function_;
+};
+
+} // namespace mcts
+
+#endif // PYTHON_PYTHON_VALUE_HEURISTIC_HPP_
@@ -20,8 +20,15 @@ def is_equal_mcts_params(mctsp1, mctsp2):
         mctsp1.RANDOM_SEED == mctsp2.RANDOM_SEED and \
         mctsp1.MAX_SEARCH_TIME == mctsp2.MAX_SEARCH_TIME and \
         mctsp1.MAX_NUMBER_OF_ITERATIONS == mctsp2.MAX_NUMBER_OF_ITERATIONS and \
+        mctsp1.REUSE_TREE_ITERATIONS == mctsp2.REUSE_TREE_ITERATIONS and \
+        mctsp1.TRANSPOSITION_TABLE == mctsp2.TRANSPOSITION_TABLE and \
         mctsp1.random_heuristic.MAX_SEARCH_TIME == mctsp2.random_heuristic.MAX_SEARCH_TIME and \
         mctsp1.random_heuristic.MAX_NUMBER_OF_ITERATIONS == mctsp2.random_heuristic.MAX_NUMBER_OF_ITERATIONS and \
+        mctsp1.random_heuristic.ROLLOUT_HORIZON == mctsp2.random_heuristic.ROLLOUT_HORIZON and \
+        mctsp1.random_heuristic.COMMON_RANDOM_NUMBERS == mctsp2.random_heuristic.COMMON_RANDOM_NUMBERS and \
+        mctsp1.random_heuristic.MAX_NUMBER_OF_ROLLOUTS == mctsp2.random_heuristic.MAX_NUMBER_OF_ROLLOUTS and \
+        mctsp1.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD == mctsp2.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD and \
+        mctsp1.random_heuristic.MAX_LEAF_EVALUATION_TIME == mctsp2.random_heuristic.MAX_LEAF_EVALUATION_TIME and \
         mctsp1.uct_statistic.LOWER_BOUND == mctsp2.uct_statistic.LOWER_BOUND and \
         mctsp1.uct_statistic.UPPER_BOUND == mctsp2.uct_statistic.UPPER_BOUND and \
         mctsp1.uct_statistic.EXPLORATION_CONSTANT == mctsp2.uct_statistic.EXPLORATION_CONSTANT and \
@@ -37,7 +44,15 @@ def is_equal_mcts_params(mctsp1, mctsp2):
         mctsp1.hypothesis_belief_tracker.HISTORY_LENGTH == mctsp2.hypothesis_belief_tracker.HISTORY_LENGTH and \
         mctsp1.hypothesis_belief_tracker.PROBABILITY_DISCOUNT == mctsp2.hypothesis_belief_tracker.PROBABILITY_DISCOUNT and \
         mctsp1.hypothesis_belief_tracker.POSTERIOR_TYPE == mctsp2.hypothesis_belief_tracker.POSTERIOR_TYPE and \
-        mctsp1.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET == mctsp2.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET
+        mctsp1.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET == mctsp2.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET and \
+        mctsp1.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE == \
+                 mctsp2.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE and \
+        mctsp1.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS == \
+                 mctsp2.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS and \
+        mctsp1.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD == \
+                 mctsp2.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD and \
+        mctsp1.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS == mctsp2.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS and \
+        mctsp1.leaf_evaluation_pipeline.BATCH_SIZE == mctsp2.leaf_evaluation_pipeline.BATCH_SIZE
 
 def is_equal_crossing_state_params(cp1, cp2):
     return cp1.NUM_OTHER_AGENTS == cp2.NUM_OTHER_AGENTS and \
@@ -67,8 +82,15 @@ class WrapperTests(unittest.TestCase):
         params_mcts.RANDOM_SEED = 1000
         params_mcts.MAX_SEARCH_TIME = 1232423
         params_mcts.MAX_NUMBER_OF_ITERATIONS = 2315677
+        params_mcts.REUSE_TREE_ITERATIONS = 500
+        params_mcts.TRANSPOSITION_TABLE = True
         params_mcts.random_heuristic.MAX_SEARCH_TIME = 10
         params_mcts.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000
+        params_mcts.random_heuristic.ROLLOUT_HORIZON = 40
+        params_mcts.random_heuristic.COMMON_RANDOM_NUMBERS = True
+        params_mcts.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 8
+        params_mcts.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.5
+        params_mcts.random_heuristic.MAX_LEAF_EVALUATION_TIME = 20
 
         params_mcts.uct_statistic.LOWER_BOUND = -1000
         params_mcts.uct_statistic.UPPER_BOUND = 100
@@ -87,6 +109,12 @@ class WrapperTests(unittest.TestCase):
         params_mcts.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 1.0
         params_mcts.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker.PosteriorType.PRODUCT
         params_mcts.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET = {1: 5, 10: 4, 3 : 100}
+        params_mcts.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = True
+        params_mcts.hypothesis_belief_tracker.NUM_BELIEF_UPDATE_THREADS = 2
+        params_mcts.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.01
+
+        params_mcts.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 4
+        params_mcts.leaf_evaluation_pipeline.BATCH_SIZE = 8
         params_mcts_unpickle = pu(params_mcts)
         self.assertTrue(is_equal_mcts_params(params_mcts, params_mcts_unpickle))
 
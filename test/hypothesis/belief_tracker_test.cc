@@ -50,9 +50,9 @@ TEST(belief_tracker, simple_tracking_state)
     const uint num_samples = 10000;
     for(uint i = 0; i < num_samples; ++i) {
       const auto& sampled = tracker.sample_current_hypothesis();
-      for (auto agent_it : sampled) {
-        auto& count_agent =  counts[agent_it.first];
-        count_agent[sampled.at(agent_it.first)]++;
+      for (auto agent_idx : sampled.agents()) {
+        auto& count_agent =  counts[agent_idx];
+        count_agent[sampled.at(agent_idx)]++;
       }
     }
 
@@ -63,6 +63,139 @@ TEST(belief_tracker, simple_tracking_state)
     
 }
 
+TEST(belief_tracker, long_history_product_no_underflow)
+{
+    auto mcts_parameters = mcts_default_parameters();
+    mcts_parameters.hypothesis_belief_tracker.HISTORY_LENGTH = 2000;
+    mcts_parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 0.9;
+    mcts_parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker::PosteriorType::PRODUCT;
+    HypothesisBeliefTracker tracker(mcts_parameters);
+
+    BeliefTrackerTestState state(tracker.sample_current_hypothesis()); 
+    BeliefTrackerTestState state2(tracker.sample_current_hypothesis()); 
+    for (unsigned int i = 0; i < 2500; ++i) {
+      tracker.belief_update(state, state2);
+    }
+    // Products of the full window underflow in linear space, the more probable hypothesis dominates
+    auto beliefs = tracker.get_beliefs();
+    EXPECT_NEAR(beliefs[0][0], 0.0, 0.000001);
+    EXPECT_NEAR(beliefs[0][1], 1.0, 0.000001);
+    EXPECT_NEAR(beliefs[1][0] + beliefs[1][1], 1.0, 0.000001);
+}
+
+TEST(belief_tracker, windowed_discounted_sum)
+{
+    auto mcts_parameters = mcts_default_parameters();
+    mcts_parameters.hypothesis_belief_tracker.HISTORY_LENGTH = 3;
+    mcts_parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 0.9;
+    mcts_parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker::PosteriorType::SUM;
+    HypothesisBeliefTracker tracker(mcts_parameters);
+
+    BeliefTrackerTestState state(tracker.sample_current_hypothesis()); 
+    BeliefTrackerTestState state2(tracker.sample_current_hypothesis()); 
+    for (unsigned int i = 0; i < 5; ++i) {
+      tracker.belief_update(state, state2);
+    }
+    // Only the last three probabilities remain, discounted with 0.9, 0.9^2 and 0.9^3
+    const double discount = 0.9 + 0.9*0.9 + 0.9*0.9*0.9;
+    auto beliefs = tracker.get_beliefs();
+    const double belief_hy1 = 0.0001 + 0.3*discount;
+    const double belief_hy2 = 0.0001 + 0.7*discount;
+    EXPECT_NEAR(beliefs[0][0], belief_hy1/(belief_hy1 + belief_hy2), 0.000001);
+    EXPECT_NEAR(beliefs[0][1], belief_hy2/(belief_hy1 + belief_hy2), 0.000001);
+}
+
+TEST(belief_tracker, alias_table_sampling)
+{
+    const std::vector<Belief> beliefs = {0.1, 0.0, 0.6, 0.3};
+    AliasTable alias_table(beliefs);
+    std::mt19937 random_generator(1000);
+    std::vector<unsigned int> counts(beliefs.size(), 0);
+    const unsigned int num_samples = 100000;
+    for (unsigned int i = 0; i < num_samples; ++i) {
+      counts[alias_table.sample<HypothesisId>(random_generator)]++;
+    }
+    for (HypothesisId hid = 0; hid < beliefs.size(); ++hid) {
+      EXPECT_NEAR(counts[hid]/float(num_samples), beliefs[hid], 0.01);
+    }
+    EXPECT_EQ(counts[1], 0);
+}
+
+TEST(belief_tracker, stratified_hypothesis_schedule)
+{
+    auto mcts_parameters = mcts_default_parameters();
+    mcts_parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = true;
+    HypothesisBeliefTracker tracker(mcts_parameters);
+
+    BeliefTrackerTestState state(tracker.sample_current_hypothesis()); 
+    BeliefTrackerTestState state2(tracker.sample_current_hypothesis()); 
+    tracker.belief_update(state, state2);
+    auto beliefs = tracker.get_beliefs();
+
+    // Each hypothesis is scheduled within one iteration of its expected count
+    const unsigned int num_iterations = 1000;
+    tracker.schedule_hypotheses(num_iterations);
+    std::unordered_map<AgentIdx, std::unordered_map<HypothesisId,uint>> counts;
+    for (unsigned int iteration = 0; iteration < num_iterations; ++iteration) {
+      const auto& sampled = tracker.sample_current_hypothesis(iteration);
+      for (auto agent_idx : sampled.agents()) {
+        counts[agent_idx][sampled.at(agent_idx)]++;
+      }
+    }
+    for (const auto& agent_it : beliefs) {
+      for (HypothesisId hid = 0; hid < agent_it.second.size(); ++hid) {
+        EXPECT_NEAR(counts[agent_it.first][hid], agent_it.second[hid]*num_iterations, 1.0);
+      }
+    }
+}
+
+TEST(belief_tracker, belief_pruning)
+{
+    auto mcts_parameters = mcts_default_parameters();
+    mcts_parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.2;
+    HypothesisBeliefTracker tracker(mcts_parameters);
+
+    BeliefTrackerTestState state(tracker.sample_current_hypothesis()); 
+    BeliefTrackerTestState state2(tracker.sample_current_hypothesis()); 
+    tracker.belief_update(state, state2);
+    tracker.belief_update(state, state2);
+    auto beliefs = tracker.get_beliefs();
+    ASSERT_LT(beliefs[0][0], 0.2);
+    ASSERT_GT(beliefs[1][0], 0.2);
+
+    // Beliefs are still reported, only sampling skips the pruned hypothesis
+    const auto pruned_hypotheses = tracker.get_pruned_hypotheses();
+    EXPECT_EQ(pruned_hypotheses.size(), 1);
+    EXPECT_EQ(pruned_hypotheses.at(0), std::vector<HypothesisId>{0});
+
+    std::unordered_map<AgentIdx, std::unordered_map<HypothesisId,uint>> counts;
+    const uint num_samples = 10000;
+    for(uint i = 0; i < num_samples; ++i) {
+      const auto& sampled = tracker.sample_current_hypothesis();
+      for (auto agent_idx : sampled.agents()) {
+        counts[agent_idx][sampled.at(agent_idx)]++;
+      }
+    }
+    EXPECT_EQ(counts[0][0], 0);
+    EXPECT_EQ(counts[0][1], num_samples);
+    EXPECT_NEAR(counts[1][0]/float(num_samples), beliefs[1][0], 0.01);
+
+    // A threshold above all beliefs keeps the most likely hypothesis of each agent
+    mcts_parameters.hypothesis_belief_tracker.BELIEF_PRUNING_THRESHOLD = 0.95;
+    mcts_parameters.hypothesis_belief_tracker.STRATIFIED_HYPOTHESIS_SCHEDULE = true;
+    HypothesisBeliefTracker strict_tracker(mcts_parameters);
+    BeliefTrackerTestState strict_state(strict_tracker.sample_current_hypothesis()); 
+    BeliefTrackerTestState strict_state2(strict_tracker.sample_current_hypothesis()); 
+    strict_tracker.belief_update(strict_state, strict_state2);
+    strict_tracker.belief_update(strict_state, strict_state2);
+    strict_tracker.schedule_hypotheses(100);
+    for (unsigned int iteration = 0; iteration < 100; ++iteration) {
+      const auto& sampled = strict_tracker.sample_current_hypothesis(iteration);
+      EXPECT_EQ(sampled.at(0), 1);
+      EXPECT_EQ(sampled.at(1), 1);
+    }
+}
+
 TEST(belief_tracker, fixed_hypothesis_set)
 {
   auto mcts_parameters = mcts_default_parameters();
@@ -74,7 +207,10 @@ TEST(belief_tracker, fixed_hypothesis_set)
   BeliefTrackerTestState state2(tracker.sample_current_hypothesis()); 
   tracker.belief_update(state, state2); //< last action equal in both states
   const auto& sampled_hypothesis = tracker.sample_current_hypothesis();
-  EXPECT_EQ(mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET, sampled_hypothesis);
+  EXPECT_EQ(mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET.size(), sampled_hypothesis.size());
+  for (const auto& fixed_hypothesis : mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET) {
+    EXPECT_EQ(fixed_hypothesis.second, sampled_hypothesis.at(fixed_hypothesis.first));
+  }
 }
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -16,7 +16,7 @@ using namespace mcts;
 class BeliefTrackerTestState : public mcts::HypothesisStateInterface<BeliefTrackerTestState>
 {
 public:
-    BeliefTrackerTestState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) :
+    BeliefTrackerTestState(const HypothesisContext& current_agents_hypothesis) :
                      HypothesisStateInterface<BeliefTrackerTestState>(current_agents_hypothesis) {}
     ~BeliefTrackerTestState() {};
 
@@ -66,8 +66,8 @@ public:
 
     HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return 2;}
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{0, 1};
+    AgentIdxRange get_other_agent_idx_range() const {
+        return AgentIdxRange(0, 2);
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -21,9 +21,9 @@ using namespace mcts;
 
 
 TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
-  std::unordered_map<AgentIdx, HypothesisId> current_agents_hypothesis = {
+  HypothesisContext current_agents_hypothesis({
       {1,0}, {2,1}
-  };
+  });
 
   // First iteration with hypothesis 0 for agent 1
   HypothesisStatisticTestState state(current_agents_hypothesis);
@@ -32,11 +32,8 @@ TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
   EXPECT_EQ(action_idx, 5);
   stat_parent.collect( 1, 2.3f, action_idx);
 
-  HypothesisStatistic heuristic(5,1, mcts_default_parameters());
-  heuristic.set_heuristic_estimate(10.0f , 20.0f);
-
   HypothesisStatistic stat_child(5,1, mcts_default_parameters());
-  stat_child.update_from_heuristic(heuristic);
+  stat_child.update_from_heuristic(10.0f, 20.0f);
   stat_parent.update_statistic(stat_child);
 
   const auto ucb_stats =stat_parent.get_ucb_statistics();
@@ -48,11 +45,8 @@ TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
   EXPECT_EQ(node_counts.at(0), 1);
 
   // Second update with hypothesis 0 for agent 1, action is the same as only one action available
-  HypothesisStatistic heuristic2(5,1, mcts_default_parameters());
-  heuristic2.set_heuristic_estimate(15.0f , 24.5f);
-
   HypothesisStatistic stat_child2(5,1, mcts_default_parameters());
-  stat_child2.update_from_heuristic(heuristic2);
+  stat_child2.update_from_heuristic(15.0f, 24.5f);
   auto action_idx2 = stat_parent.choose_next_action(state);
   EXPECT_EQ(action_idx2, 5);
   stat_parent.collect( 1, 4.3f, action_idx2);
@@ -69,11 +63,8 @@ TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
 
   // Third update with changed actions hypothesis 0 for agent 1
   state.change_actions();
-  HypothesisStatistic heuristic3(5,1, mcts_default_parameters());
-  heuristic3.set_heuristic_estimate(15.0f , 450.5f);
-
   HypothesisStatistic stat_child3(5,1, mcts_default_parameters());
-  stat_child3.update_from_heuristic(heuristic3);
+  stat_child3.update_from_heuristic(15.0f, 450.5f);
   auto action_idx3 = stat_parent.choose_next_action(state);
   EXPECT_EQ(action_idx3, 3);
   stat_parent.collect( -1, 1000.3f, action_idx3);
@@ -88,15 +79,11 @@ TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
   EXPECT_EQ(node_counts3.at(0), 3);
 
   // Fourth update with hypothesis 1 for agent 1 
-  current_agents_hypothesis = {
-      {1,1}, {2,1}
-  }; //< state holds a refence to current selected hypothesis
-
-  HypothesisStatistic heuristic4(5,1, mcts_default_parameters());
-  heuristic4.set_heuristic_estimate(15.0f , 45.5f);
+  current_agents_hypothesis[1] = 1;
+  current_agents_hypothesis[2] = 1; //< state holds a refence to current selected hypothesis
 
   HypothesisStatistic stat_child4(5,1, mcts_default_parameters());
-  stat_child4.update_from_heuristic(heuristic4);
+  stat_child4.update_from_heuristic(15.0f, 45.5f);
   auto action_idx4 = stat_parent.choose_next_action(state);
   EXPECT_EQ(action_idx4, 4);
   stat_parent.collect( -1, 10.3f, action_idx4);
@@ -115,19 +102,16 @@ TEST(hypothesis_statistic, backprop_hypothesis_action_selection) {
 
 TEST(hypothesis_statistic, backprop_heuristic_hyp1) {
   // Now test something for agent 2
-  const std::unordered_map<AgentIdx, HypothesisId> current_agents_hypothesis = {
+  const HypothesisContext current_agents_hypothesis({
       {1,0}, {2,1}
-  };
+  });
   HypothesisStatisticTestState state(current_agents_hypothesis);
   HypothesisStatistic stat_parent(5,2, mcts_default_parameters()); // agents 2 statistic 
   auto action_idx = stat_parent.choose_next_action(state);
   stat_parent.collect( 1, 5.3f, action_idx);
 
-  HypothesisStatistic heuristic(5,2, mcts_default_parameters());
-  heuristic.set_heuristic_estimate(10.0f , 22.0f);
-
   HypothesisStatistic stat_child(5,2, mcts_default_parameters());
-  stat_child.update_from_heuristic(heuristic);
+  stat_child.update_from_heuristic(10.0f, 22.0f);
   stat_parent.update_statistic(stat_child);
 
   const auto ucb_stats =stat_parent.get_ucb_statistics();
@@ -139,11 +123,36 @@ TEST(hypothesis_statistic, backprop_heuristic_hyp1) {
   EXPECT_EQ(node_counts.at(1), 1);
 }
 
+TEST(hypothesis_statistic, remove_pruned_hypotheses) {
+  const HypothesisContext current_agents_hypothesis({
+      {1,0}, {2,1}
+  });
+  HypothesisStatisticTestState state(current_agents_hypothesis);
+  HypothesisStatistic stat_parent(5,2, mcts_default_parameters());
+  stat_parent.choose_next_action(state);
+  stat_parent.update_from_heuristic(10.0f, 22.0f);
+  {
+    const HypothesisContext other_hypothesis({
+        {1,0}, {2,0}
+    });
+    HypothesisContextScope scope(other_hypothesis);
+    stat_parent.choose_next_action(state);
+  }
+  EXPECT_EQ(stat_parent.get_ucb_statistics().size(), 2);
+
+  stat_parent.remove_hypotheses({1});
+  const auto ucb_stats = stat_parent.get_ucb_statistics();
+  const auto node_counts = stat_parent.get_total_node_visits();
+  EXPECT_EQ(ucb_stats.size(), 1);
+  EXPECT_EQ(ucb_stats.count(0), 1);
+  EXPECT_EQ(node_counts.count(1), 0);
+}
+
 TEST(hypothesis_statistic, worst_case_action_selection) {
   // Now test something for agent 2
-  const std::unordered_map<AgentIdx, HypothesisId> current_agents_hypothesis = {
+  const HypothesisContext current_agents_hypothesis({
       {1,0}, {2,1}
-  };
+  });
 
   auto mcts_params = mcts_default_parameters();
   mcts_params.hypothesis_statistic.COST_BASED_ACTION_SELECTION = true;
@@ -155,11 +164,8 @@ TEST(hypothesis_statistic, worst_case_action_selection) {
   auto action_idx = stat_parent.choose_next_action(state);
   stat_parent.collect( 1, 5.3f, action_idx);
 
-  HypothesisStatistic heuristic(2,2, mcts_params);
-  heuristic.set_heuristic_estimate(10.0f , 22.0f);
-
   HypothesisStatistic stat_child(2,2, mcts_params);
-  stat_child.update_from_heuristic(heuristic);
+  stat_child.update_from_heuristic(10.0f, 22.0f);
   stat_parent.update_statistic(stat_child);
 
   state.change_actions();
@@ -174,6 +180,55 @@ TEST(hypothesis_statistic, worst_case_action_selection) {
 
 }
 
+TEST(hypothesis_statistic, pending_visits_per_hypothesis) {
+  const HypothesisContext current_agents_hypothesis({
+      {1,0}, {2,1}
+  });
+
+  auto mcts_params = mcts_default_parameters();
+  mcts_params.hypothesis_statistic.COST_BASED_ACTION_SELECTION = true;
+  mcts_params.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.9;
+  mcts_params.hypothesis_statistic.PROGRESSIVE_WIDENING_K = 1;
+
+  HypothesisStatisticTestState state(current_agents_hypothesis);
+  HypothesisStatistic stat_parent(5,2, mcts_params); // agents 2 statistic
+  HypothesisStatistic stat_child(5,2, mcts_params);
+  stat_child.update_from_heuristic(10.0f, 22.0f);
+
+  // Expand both actions of hypothesis 1, the second one has higher ego cost
+  auto action_low_cost = stat_parent.choose_next_action(state);
+  stat_parent.collect(1, 30.0f, action_low_cost);
+  stat_parent.update_statistic(stat_child);
+  state.change_actions();
+  auto action_high_cost = stat_parent.choose_next_action(state);
+  stat_parent.collect(1, 60.0f, action_high_cost);
+  stat_parent.update_statistic(stat_child);
+  EXPECT_NE(action_low_cost, action_high_cost);
+  EXPECT_EQ(stat_parent.choose_next_action(state), action_high_cost);
+
+  // An iteration in flight through the worst case action spreads the next one to the other action
+  stat_parent.add_pending_visit(action_high_cost);
+  EXPECT_EQ(stat_parent.get_ucb_statistics().at(1).at(action_high_cost).pending_count_, 1);
+  EXPECT_EQ(stat_parent.choose_next_action(state), action_low_cost);
+
+  // Pending visits of other hypotheses do not affect the selection under hypothesis 1
+  {
+    const HypothesisContext other_hypothesis({
+        {1,0}, {2,0}
+    });
+    HypothesisContextScope scope(other_hypothesis);
+    stat_parent.add_pending_visit(action_high_cost);
+    EXPECT_EQ(stat_parent.get_ucb_statistics().at(0).at(action_high_cost).pending_count_, 1);
+    stat_parent.remove_pending_visit(action_high_cost);
+    EXPECT_EQ(stat_parent.get_ucb_statistics().at(0).at(action_high_cost).pending_count_, 0);
+  }
+  EXPECT_EQ(stat_parent.get_ucb_statistics().at(1).at(action_high_cost).pending_count_, 1);
+
+  stat_parent.remove_pending_visit(action_high_cost);
+  EXPECT_EQ(stat_parent.get_ucb_statistics().at(1).at(action_high_cost).pending_count_, 0);
+  EXPECT_EQ(stat_parent.choose_next_action(state), action_high_cost);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
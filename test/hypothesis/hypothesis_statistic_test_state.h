@@ -16,13 +16,13 @@ using namespace mcts;
 class HypothesisStatisticTestState : public mcts::HypothesisStateInterface<HypothesisStatisticTestState>
 {
 public:
-    HypothesisStatisticTestState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) :
+    HypothesisStatisticTestState(const HypothesisContext& current_agents_hypothesis) :
                      HypothesisStateInterface<HypothesisStatisticTestState>(current_agents_hypothesis),
                      use_first_action_(true) {}
     ~HypothesisStatisticTestState() {};
 
     ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const {
-        switch(current_agents_hypothesis_.at(agent_idx)) {
+        switch(get_current_hypothesis(agent_idx)) {
             case 0: 
                 if(use_first_action_) {
                      return 5;
@@ -43,8 +43,8 @@ public:
 
     void change_actions() {use_first_action_ = !use_first_action_;}
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{1};
+    AgentIdxRange get_other_agent_idx_range() const {
+        return AgentIdxRange(1, 2);
     }
 
     const AgentIdx get_ego_agent_idx() const {
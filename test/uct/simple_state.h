@@ -12,7 +12,7 @@
 using namespace mcts;
 
 // A simple environment with a 1D state, only if both agents select different actions, they get nearer to the terminal state
-class SimpleState : public mcts::StateInterface<SimpleState>
+class SimpleState : public mcts::StateInterface<SimpleState>, public mcts::SupportsHashing
 {
 public:
     SimpleState(int length) : state_length_(length), winning_state_length_(10), loosing_state_length_(-1) {};
@@ -27,6 +27,7 @@ public:
         // normally we map each single action value in joint action with a map to the floating point action. Here, not required
         rewards.resize(2);
         rewards[0] = 0; rewards[1] = 0;
+        ego_cost = 0;
         if(joint_action == JointAction{0,0} || joint_action == JointAction{1,1})
         {
             return std::make_shared<SimpleState>(*this);
@@ -61,8 +62,8 @@ public:
         return state_length_ >= winning_state_length_ || state_length_ <= loosing_state_length_;
     }
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{5};
+    AgentIdxRange get_other_agent_idx_range() const {
+        return AgentIdxRange(5, 6);
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -70,6 +71,14 @@ public:
     }
 
 
+    std::size_t hash() const {
+        return std::hash<int>()(state_length_);
+    }
+
+    bool equals(const SimpleState& other) const {
+        return state_length_ == other.state_length_;
+    }
+
     std::string sprintf() const
     {
         std::stringstream ss;
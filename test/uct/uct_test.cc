@@ -14,6 +14,9 @@
 #include "mcts/statistics/uct_statistic.h"
 #include "test/uct/simple_state.h"
 #include <cstdio>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
 
 using namespace std;
 using namespace mcts;
@@ -25,14 +28,24 @@ MctsParameters default_uct_params() {
   parameters.RANDOM_SEED = 1000;
   parameters.MAX_NUMBER_OF_ITERATIONS = 10000;
   parameters.MAX_SEARCH_TIME = 1000;
+  parameters.REUSE_TREE_ITERATIONS = 0;
+  parameters.TRANSPOSITION_TABLE = false;
   
   parameters.random_heuristic.MAX_SEARCH_TIME = 10;
   parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000;
+  parameters.random_heuristic.ROLLOUT_HORIZON = 0;
+  parameters.random_heuristic.COMMON_RANDOM_NUMBERS = false;
+  parameters.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 1;
+  parameters.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.0;
+  parameters.random_heuristic.MAX_LEAF_EVALUATION_TIME = 100;
 
   parameters.uct_statistic.LOWER_BOUND = -1000;
   parameters.uct_statistic.UPPER_BOUND = 100;
   parameters.uct_statistic.EXPLORATION_CONSTANT = 0.7;
 
+  parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 0;
+  parameters.leaf_evaluation_pipeline.BATCH_SIZE = 1;
+
   return parameters;
 }
 
@@ -48,6 +61,216 @@ TEST(test_mcts, verify_uct )
 
 }
 
+// Bootstraps each truncated rollout with a constant return for all agents
+class ConstantValueEstimator : public mcts::ValueEstimator<ConstantValueEstimator>
+{
+public:
+    ConstantValueEstimator(const MctsParameters& mcts_parameters) :
+            mcts::ValueEstimator<ConstantValueEstimator>(mcts_parameters) {}
+
+    template<class S>
+    void estimate_value(const S& state, std::vector<Reward>& values, Cost& ego_cost) const {
+        values.assign(state.get_num_agents(), 2.0f);
+        ego_cost = 0.0f;
+    }
+};
+
+TEST(test_mcts, verify_uct_truncated_rollouts )
+{
+    auto parameters = default_uct_params();
+    parameters.random_heuristic.ROLLOUT_HORIZON = 5;
+    Mcts<SimpleState, UctStatistic, UctStatistic, TruncatedRandomHeuristic<ConstantValueEstimator>> mcts(parameters);
+    SimpleState state(4);
+
+    mcts.search(state);
+
+    UctTest test;
+    test.verify_uct(mcts,1);
+}
+
+TEST(test_mcts, verify_uct_multiple_rollouts )
+{
+    auto parameters = default_uct_params();
+    parameters.MAX_NUMBER_OF_ITERATIONS = 500;
+    parameters.random_heuristic.MAX_NUMBER_OF_ROLLOUTS = 4;
+    parameters.random_heuristic.ROLLOUT_STANDARD_ERROR_THRESHOLD = 0.0;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(parameters);
+    SimpleState state(4);
+
+    mcts.search(state);
+    // Rollouts of the simple state are deterministic, the standard error vanishes after the second rollout
+    EXPECT_GT(mcts.numRollouts(), mcts.numIterations());
+    EXPECT_LE(mcts.numRollouts(), 2*mcts.numIterations());
+
+    UctTest test;
+    test.verify_uct(mcts,1);
+}
+
+TEST(test_mcts, verify_uct_pipelined_leaf_evaluation )
+{
+    auto parameters = default_uct_params();
+    parameters.MAX_NUMBER_OF_ITERATIONS = 1000;
+    parameters.MAX_SEARCH_TIME = 100000;
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 4;
+    parameters.leaf_evaluation_pipeline.BATCH_SIZE = 4;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(parameters);
+    SimpleState state(4);
+
+    mcts.search(state);
+    EXPECT_EQ(mcts.numIterations(), parameters.MAX_NUMBER_OF_ITERATIONS);
+
+    UctTest test;
+    test.verify_uct(mcts,1);
+}
+
+TEST(test_mcts, verify_uct_batched_leaf_evaluation_in_search_thread )
+{
+    auto parameters = default_uct_params();
+    parameters.MAX_NUMBER_OF_ITERATIONS = 1000;
+    parameters.MAX_SEARCH_TIME = 100000;
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 0;
+    parameters.leaf_evaluation_pipeline.BATCH_SIZE = 4;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(parameters);
+    SimpleState state(4);
+
+    mcts.search(state);
+    EXPECT_EQ(mcts.numIterations(), parameters.MAX_NUMBER_OF_ITERATIONS);
+
+    UctTest test;
+    test.verify_uct(mcts,1);
+}
+
+// Fails every leaf evaluation
+class ThrowingHeuristic : public mcts::Heuristic<ThrowingHeuristic>
+{
+public:
+    ThrowingHeuristic(const MctsParameters& mcts_parameters) : mcts::Heuristic<ThrowingHeuristic>(mcts_parameters) {}
+
+    template<class S, class SE, class SO, class H>
+    HeuristicValue calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>>&) {
+        throw std::runtime_error("leaf evaluation failed");
+    }
+
+    std::string sprintf() const { return "ThrowingHeuristic"; }
+};
+
+TEST(test_mcts, pipelined_leaf_evaluation_rethrows_heuristic_exception )
+{
+    auto parameters = default_uct_params();
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 4;
+    parameters.leaf_evaluation_pipeline.BATCH_SIZE = 4;
+    Mcts<SimpleState, UctStatistic, UctStatistic, ThrowingHeuristic> mcts(parameters);
+    SimpleState state(4);
+
+    EXPECT_THROW(mcts.search(state), std::runtime_error);
+}
+
+TEST(test_mcts, verify_uct_reused_tree )
+{
+    auto parameters = default_uct_params();
+    parameters.MAX_NUMBER_OF_ITERATIONS = 1000;
+    parameters.MAX_SEARCH_TIME = 100000;
+    parameters.REUSE_TREE_ITERATIONS = 500;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(parameters);
+    SimpleState state(4);
+    mcts.search(state);
+
+    std::vector<Reward> rewards;
+    Cost cost;
+    const JointAction joint_action{mcts.returnBestAction(), 0};
+    const auto next_state = state.execute(joint_action, rewards, cost);
+    ASSERT_TRUE(mcts.reroot(joint_action));
+
+    // The top-up search continues the statistics of the kept subtree
+    mcts.search(*next_state);
+    EXPECT_EQ(mcts.numIterations(), parameters.REUSE_TREE_ITERATIONS);
+    UctTest test;
+    test.verify_uct_reused_tree(mcts,1);
+
+    // Without reuse the next search starts a new tree
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts_no_reuse(default_uct_params());
+    mcts_no_reuse.search(state);
+    EXPECT_FALSE(mcts_no_reuse.reroot(joint_action));
+}
+
+TEST(test_mcts, transposition_table_merges_equal_states )
+{
+    auto parameters = default_uct_params();
+    parameters.MAX_NUMBER_OF_ITERATIONS = 500;
+    parameters.MAX_SEARCH_TIME = 100000;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts_tree(parameters);
+    SimpleState state(4);
+    mcts_tree.search(state);
+    UctTest test;
+    // Equal state lengths at equal depth are reached by many orders of self-loops and steps forward
+    const auto tree_nodes_and_states = test.count_nodes_and_states(mcts_tree);
+    EXPECT_EQ(tree_nodes_and_states.first, mcts_tree.numNodes());
+    EXPECT_GT(tree_nodes_and_states.first, tree_nodes_and_states.second);
+
+    parameters.TRANSPOSITION_TABLE = true;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts_dag(parameters);
+    mcts_dag.search(state);
+    EXPECT_EQ(mcts_dag.numIterations(), parameters.MAX_NUMBER_OF_ITERATIONS);
+    const auto dag_nodes_and_states = test.count_nodes_and_states(mcts_dag);
+    EXPECT_EQ(dag_nodes_and_states.first, mcts_dag.numNodes());
+    EXPECT_EQ(dag_nodes_and_states.first, dag_nodes_and_states.second);
+    EXPECT_EQ(mcts_dag.returnBestAction(), mcts_tree.returnBestAction());
+}
+
+TEST(test_mcts, transposition_table_rejected_by_pipelined_search )
+{
+    auto parameters = default_uct_params();
+    parameters.TRANSPOSITION_TABLE = true;
+    parameters.leaf_evaluation_pipeline.NUM_EVALUATOR_THREADS = 4;
+    // Pending visits could not be backpropagated to all parents of a node
+    using UctMcts = Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic>;
+    EXPECT_DEATH(UctMcts mcts(parameters), "TRANSPOSITION_TABLE");
+}
+
+TEST(test_mcts, heuristic_value_bootstrapped_for_all_agents )
+{
+    auto parameters = default_uct_params();
+    parameters.random_heuristic.ROLLOUT_HORIZON = 1;
+    using ZeroHeuristic = TruncatedRandomHeuristic<ZeroValueEstimator>;
+    using ConstantHeuristic = TruncatedRandomHeuristic<ConstantValueEstimator>;
+    auto node = std::make_shared<StageNode<SimpleState, UctStatistic, UctStatistic, ZeroHeuristic>>(
+                    nullptr, std::make_shared<SimpleState>(4), JointAction(), 0, parameters);
+    auto bootstrapped_node = std::make_shared<StageNode<SimpleState, UctStatistic, UctStatistic, ConstantHeuristic>>(
+                    nullptr, std::make_shared<SimpleState>(4), JointAction(), 0, parameters);
+
+    // Equal seeds yield the same single rollout step, both values only differ by the discounted tail estimate
+    const HeuristicValue value = ZeroHeuristic(parameters).calculate_heuristic_values(node);
+    const HeuristicValue bootstrapped_value = ConstantHeuristic(parameters).calculate_heuristic_values(bootstrapped_node);
+    ASSERT_EQ(value.returns.size(), 2);
+    ASSERT_EQ(bootstrapped_value.returns.size(), 2);
+    const double tail_discount = parameters.DISCOUNT_FACTOR*parameters.DISCOUNT_FACTOR;
+    for (AgentIdx ai = 0; ai < value.returns.size(); ++ai) {
+        EXPECT_NEAR(bootstrapped_value.returns[ai] - value.returns[ai], tail_discount*2.0f, 0.001);
+    }
+    EXPECT_NEAR(bootstrapped_value.ego_cost, value.ego_cost, 0.001);
+}
+
+TEST(test_mcts, agent_idx_range )
+{
+    const AgentIdxRange contiguous(3, 6);
+    EXPECT_TRUE(contiguous.is_contiguous());
+    EXPECT_EQ(std::vector<AgentIdx>(contiguous.begin(), contiguous.end()), std::vector<AgentIdx>({3, 4, 5}));
+    EXPECT_EQ(contiguous[1], 4);
+    EXPECT_TRUE((std::is_same<std::iterator_traits<AgentIdxRange::const_iterator>::iterator_category,
+                              std::input_iterator_tag>::value));
+
+    const std::vector<AgentIdx> indices{2, 7, 9};
+    const AgentIdxRange view(indices);
+    EXPECT_FALSE(view.is_contiguous());
+    EXPECT_EQ(std::vector<AgentIdx>(view.begin(), view.end()), indices);
+    EXPECT_EQ(view.size(), 3);
+    EXPECT_EQ(view[2], 9);
+
+    const SimpleState state(4);
+    EXPECT_EQ(state.get_other_agent_idx(), std::vector<AgentIdx>({5}));
+    EXPECT_EQ(state.get_num_agents(), 2);
+}
+
 TEST(test_mcts, generate_dot_file )
 {
     Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(default_uct_params());
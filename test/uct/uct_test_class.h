@@ -10,6 +10,8 @@
 #include "mcts/mcts.h"
 #include "mcts/heuristics/random_heuristic.h"
 #include "mcts/statistics/uct_statistic.h"
+#include <set>
+#include <unordered_set>
 
 using namespace mcts;
 using namespace std;
@@ -24,6 +26,34 @@ public:
         std::unordered_map<AgentIdx, UctStatistic> expected_root_statistics = verify_uct(mcts.root_, depth);
     }
 
+    // The root of a reused tree was expanded as a leaf before, only the subtrees of its children are verified
+    template< class S, class SE, class SO, class H>
+    void verify_uct_reused_tree(const Mcts<S, SE, SO, H>& mcts, unsigned int depth) {
+        for (const auto& child : mcts.root_->children_) {
+            verify_uct(child.second, depth);
+        }
+    }
+
+    // Counts the nodes reachable from the root and their distinct states, equal states at different depths are distinct
+    template< class S, class SE, class SO, class H>
+    std::pair<std::size_t, std::size_t> count_nodes_and_states(const Mcts<S, SE, SO, H>& mcts) {
+        std::unordered_set<const StageNode<S,SE,SO,H>*> nodes;
+        std::set<std::pair<unsigned int, std::size_t>> states;
+        std::vector<const StageNode<S,SE,SO,H>*> open_nodes{mcts.root_.get()};
+        while (!open_nodes.empty()) {
+            const auto node = open_nodes.back();
+            open_nodes.pop_back();
+            if (!nodes.insert(node).second) {
+                continue;
+            }
+            states.emplace(node->depth_, node->state_->hash());
+            for (const auto& child : node->children_) {
+                open_nodes.push_back(child.second.get());
+            }
+        }
+        return std::make_pair(nodes.size(), states.size());
+    }
+
     template< class S, class H>
     std::unordered_map<AgentIdx, UctStatistic> verify_uct(const StageNodeSPtr<S,UctStatistic,UctStatistic,H>& start_node, unsigned int depth)
     {
@@ -59,6 +59,13 @@ cc_library(
       remote = "https://github.com/google/glog"
     )
 
+    _maybe(
+    http_archive,
+    name = "com_github_google_benchmark",
+    strip_prefix = "benchmark-1.5.0",
+    urls = ["https://github.com/google/benchmark/archive/v1.5.0.zip"],
+    )
+
     _maybe(
     http_archive, 
     name = "com_github_eigen_eigen",